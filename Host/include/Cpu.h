@@ -0,0 +1,247 @@
+/*
+ * Cpu.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CPU_H_
+#define CPU_H_
+
+/*
+ * Host simulation: replaces the Processor Expert Cpu.h (Generated_Code/Cpu.h).
+ * Only the device registers, S32 SDK drivers and generated components used by the bootloader are declared,
+ * they are implemented by the simulator (Host/sim_*.c).
+ */
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "stddef.h"
+#include "flash_driver.h"
+#include "sim.h"
+
+#ifdef UART_RX_USE_DMA
+#error "The host simulation has no eDMA, build without UART_RX_USE_DMA"
+#endif
+#ifdef TRACE_ENABLE
+#error "The host simulation has no DWT cycle counter, build without TRACE_ENABLE"
+#endif
+
+// The code is in host memory, the RAM section attributes are not needed.
+#define START_FUNCTION_DECLARATION_RAMSECTION
+#define END_FUNCTION_DECLARATION_RAMSECTION		;
+#define START_FUNCTION_DEFINITION_RAMSECTION
+#define END_FUNCTION_DEFINITION_RAMSECTION
+
+/*
+ * Interrupts
+ */
+typedef enum
+{
+	SVCall_IRQn					= -5,
+	UsageFault_IRQn				= -10,
+	FTFC_IRQn					= 18,
+	LPUART0_RxTx_IRQn			= 31,
+	LPIT0_Ch0_IRQn				= 48,
+	SWI_IRQn					= 115,
+	WDOG_EWM_IRQn				= 22
+} IRQn_Type;
+
+typedef void (* isr_t)(void);
+
+#define FEATURE_NVIC_PRIO_BITS					(4u)
+
+void INT_SYS_InstallHandler(IRQn_Type irqNumber, const isr_t newHandler, isr_t * const oldHandler);
+void INT_SYS_EnableIRQ(IRQn_Type irqNumber);
+void INT_SYS_DisableIRQ(IRQn_Type irqNumber);
+void INT_SYS_EnableIRQGlobal(void);
+void INT_SYS_DisableIRQGlobal(void);
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority);
+uint8_t INT_SYS_GetPriority(IRQn_Type irqNumber);
+void INT_SYS_ClearPending(IRQn_Type irqNumber);
+void INT_SYS_SetPending(IRQn_Type irqNumber);
+uint32_t INT_SYS_GetActive(IRQn_Type irqNumber);
+
+void SystemSoftwareReset(void);
+
+typedef struct
+{
+	volatile uint32_t VTOR;
+} S32_SCB_Type;
+
+extern S32_SCB_Type sim_S32_SCB;
+#define S32_SCB									(&sim_S32_SCB)
+
+/*
+ * Reset control module: a start of the simulator is a power-on reset, a simulated reset is a software reset.
+ * The sticky flags are cleared by writing 1.
+ */
+typedef struct
+{
+	volatile uint32_t SRS;
+	volatile uint32_t SSRS;
+} RCM_Type;
+
+extern RCM_Type sim_RCM;
+#define RCM										(&sim_RCM)
+
+#define RCM_SRS_LVD_MASK						0x2u
+#define RCM_SRS_POR_MASK						0x80u
+#define RCM_SRS_SW_MASK							0x400u
+#define RCM_SSRS_SLVD_MASK						0x2u
+#define RCM_SSRS_SPOR_MASK						0x80u
+#define RCM_SSRS_SSW_MASK						0x400u
+
+/*
+ * Clock and pins
+ */
+typedef enum
+{
+	CORE_CLOCK,
+	BUS_CLOCK,
+	LPUART0_CLK,
+	LPIT0_CLK
+} clock_names_t;
+
+typedef struct
+{
+	uint32_t reserved;
+} clock_manager_user_config_t;
+
+typedef struct
+{
+	uint32_t reserved;
+} pin_settings_config_t;
+
+typedef struct
+{
+	volatile uint32_t PDOR;
+} GPIO_Type;
+
+extern GPIO_Type sim_PTE;
+#define PTE										(&sim_PTE)
+
+#define NUM_OF_CONFIGURED_PINS					58
+
+extern clock_manager_user_config_t clockManager1_InitConfig0;
+extern pin_settings_config_t g_pin_mux_InitConfigArr[NUM_OF_CONFIGURED_PINS];
+
+status_t CLOCK_DRV_Init(clock_manager_user_config_t const * config);
+status_t CLOCK_SYS_GetFreq(clock_names_t clockName, uint32_t * frequency);
+status_t PINS_DRV_Init(uint32_t pinCount, const pin_settings_config_t config[]);
+void PINS_DRV_SetPins(GPIO_Type * const base, uint32_t pins);
+void PINS_DRV_ClearPins(GPIO_Type * const base, uint32_t pins);
+void PINS_DRV_TogglePins(GPIO_Type * const base, uint32_t pins);
+
+/*
+ * LPUART0
+ */
+typedef struct
+{
+	volatile uint32_t VERID;
+	volatile uint32_t PARAM;
+	volatile uint32_t GLOBAL;
+	volatile uint32_t PINCFG;
+	volatile uint32_t BAUD;
+	volatile uint32_t STAT;
+	volatile uint32_t CTRL;
+	volatile uint32_t DATA;
+	volatile uint32_t MATCH;
+	volatile uint32_t MODIR;
+	volatile uint32_t FIFO;
+	volatile uint32_t WATER;
+} LPUART_Type;
+
+extern LPUART_Type sim_LPUART0;
+#define LPUART0									(&sim_LPUART0)
+
+#define LPUART_BAUD_RDMAE_MASK					0x200000u
+#define LPUART_STAT_OR_MASK						0x80000u
+#define LPUART_STAT_IDLE_MASK					0x100000u
+#define LPUART_STAT_RDRF_MASK					0x200000u
+#define LPUART_STAT_TC_MASK						0x400000u
+#define LPUART_STAT_TDRE_MASK					0x800000u
+#define LPUART_CTRL_RE_MASK						0x40000u
+#define LPUART_CTRL_TE_MASK						0x80000u
+#define LPUART_CTRL_ILT_MASK					0x4u
+#define LPUART_CTRL_IDLECFG_MASK				0x700u
+#define LPUART_CTRL_IDLECFG_SHIFT				8u
+#define LPUART_CTRL_IDLECFG(x)					(((uint32_t)(x) << LPUART_CTRL_IDLECFG_SHIFT) & LPUART_CTRL_IDLECFG_MASK)
+#define LPUART_CTRL_ILIE_MASK					0x100000u
+#define LPUART_CTRL_RIE_MASK					0x200000u
+#define FEATURE_LPUART_STAT_REG_FLAGS_MASK		(0xC01FC000U)
+
+#define INST_LPUART0							(0U)
+
+typedef enum
+{
+	UART_EVENT_RX_FULL		= 0x00U,
+	UART_EVENT_TX_EMPTY		= 0x01U,
+	UART_EVENT_END_TRANSFER	= 0x02U,
+	UART_EVENT_ERROR		= 0x03U
+} uart_event_t;
+
+typedef void (* uart_callback_t)(void * driverState, uart_event_t event, void * userData);
+
+typedef struct
+{
+	const uint8_t * txBuff;
+	uint8_t * rxBuff;
+	volatile uint32_t txSize;
+	volatile uint32_t rxSize;
+	volatile bool isTxBusy;
+	volatile bool isRxBusy;
+	uart_callback_t rxCallback;
+	void * rxCallbackParam;
+	uart_callback_t txCallback;
+	void * txCallbackParam;
+	volatile status_t transmitStatus;
+	volatile status_t receiveStatus;
+} lpuart_state_t;
+
+typedef struct
+{
+	uint32_t baudRate;
+} lpuart_user_config_t;
+
+extern lpuart_state_t lpuart0_State;
+extern const lpuart_user_config_t lpuart0_InitConfig0;
+
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t * lpuartStatePtr, const lpuart_user_config_t * lpuartUserConfig);
+status_t LPUART_DRV_Deinit(uint32_t instance);
+uart_callback_t LPUART_DRV_InstallRxCallback(uint32_t instance, uart_callback_t function, void * callbackParam);
+void LPUART_DRV_SendDataPolling(uint32_t instance, const uint8_t * txBuff, uint32_t txSize);
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t * txBuff, uint32_t txSize);
+status_t LPUART_DRV_ReceiveData(uint32_t instance, uint8_t * rxBuff, uint32_t rxSize);
+status_t LPUART_DRV_AbortReceivingData(uint32_t instance);
+status_t LPUART_DRV_SetBaudRate(uint32_t instance, uint32_t desiredBaudRate);
+void LPUART_DRV_GetBaudRate(uint32_t instance, uint32_t * configuredBaudRate);
+void LPUART_DRV_IRQHandler(uint32_t instance);
+
+/*
+ * LPIT0
+ */
+#define INST_LPIT0								(0U)
+
+typedef struct
+{
+	bool enableRunInDebug;
+	bool enableRunInDoze;
+} lpit_user_config_t;
+
+typedef struct
+{
+	uint32_t period;						// In LPIT0 clock counts
+	bool isInterruptEnabled;
+} lpit_user_channel_config_t;
+
+extern const lpit_user_config_t lpit0_InitConfig;
+extern const lpit_user_channel_config_t lpit0_ChnConfig0;
+
+void LPIT_DRV_Init(uint32_t instance, const lpit_user_config_t * userConfig);
+status_t LPIT_DRV_InitChannel(uint32_t instance, uint32_t channel, const lpit_user_channel_config_t * userChannelConfig);
+void LPIT_DRV_StartTimerChannels(uint32_t instance, uint32_t mask);
+void LPIT_DRV_StopTimerChannels(uint32_t instance, uint32_t mask);
+uint32_t LPIT_DRV_GetInterruptFlagTimerChannels(uint32_t instance, uint32_t mask);
+void LPIT_DRV_ClearInterruptFlagTimerChannels(uint32_t instance, uint32_t mask);
+
+#endif /* CPU_H_ */
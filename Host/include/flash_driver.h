@@ -0,0 +1,166 @@
+/*
+ * flash_driver.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FLASH_DRIVER_H_
+#define FLASH_DRIVER_H_
+
+/*
+ * Host simulation: the subset of the S32 SDK flash driver (SDK/platform/drivers/inc/flash_driver.h)
+ * used by the bootloader, implemented by the simulated FTFC (sim_ftfc.c).
+ */
+
+#include "stdbool.h"
+#include "stdint.h"
+#include "stddef.h"
+#include "sim.h"
+
+typedef int32_t status_t;
+#define STATUS_SUCCESS							(0x000)
+#define STATUS_ERROR							(0x001)
+#define STATUS_BUSY								(0x002)
+#define STATUS_TIMEOUT							(0x003)
+#define STATUS_UNSUPPORTED						(0x004)
+#define STATUS_UART_ABORTED						(0x602)
+
+/*
+ * FTFC registers, the same layout as on the S32K144.
+ */
+typedef struct
+{
+	volatile uint8_t FSTAT;
+	volatile uint8_t FCNFG;
+	volatile uint8_t FSEC;
+	volatile uint8_t FOPT;
+	volatile uint8_t FCCOB[12];
+	volatile uint8_t FPROT[4];
+	uint8_t RESERVED_0[2];
+	volatile uint8_t FEPROT;
+	volatile uint8_t FDPROT;
+	uint8_t RESERVED_1[20];
+	volatile uint8_t FCSESTAT;
+	uint8_t RESERVED_2[1];
+	volatile uint8_t FERSTAT;
+	volatile uint8_t FERCNFG;
+} FTFC_Type;
+
+extern FTFC_Type sim_FTFC;
+#define FTFC									(&sim_FTFC)
+
+#define FTFC_FSTAT_MGSTAT0_MASK					0x1u
+#define FTFC_FSTAT_FPVIOL_MASK					0x10u
+#define FTFC_FSTAT_ACCERR_MASK					0x20u
+#define FTFC_FSTAT_RDCOLERR_MASK				0x40u
+#define FTFC_FSTAT_CCIF_MASK					0x80u
+#define FTFC_FCNFG_EEERDY_MASK					0x1u
+#define FTFC_FCNFG_RAMRDY_MASK					0x2u
+#define FTFC_FCNFG_CCIE_MASK					0x80u
+
+/*
+ * A command is launched by writing 1 to CCIF (write 1 to clear), which a plain memory register cannot tell.
+ * The simulation uses a reserved FSTAT bit as the launch request instead: writing FTFx_FSTAT_CCIF_MASK
+ * clears CCIF and sets the request, which the FTFC thread takes. Reading CCIF uses FTFC_FSTAT_CCIF_MASK.
+ * The masks written by the bootloader (launch, CCIE) also wake up the FTFC thread by sim_ftfc_notify().
+ */
+#define SIM_FTFC_FSTAT_LAUNCH_MASK				0x02u
+
+#define FTFx_BASE								((uintptr_t)FTFC)
+#define FTFx_FSTAT								FTFC->FSTAT
+#define FTFx_FCNFG								FTFC->FCNFG
+#define FTFx_FCCOB3								FTFC->FCCOB[0]
+#define FTFx_FCCOB2								FTFC->FCCOB[1]
+#define FTFx_FCCOB1								FTFC->FCCOB[2]
+#define FTFx_FCCOB0								FTFC->FCCOB[3]
+#define FTFx_FCCOB7								FTFC->FCCOB[4]
+#define FTFx_FCCOB6								FTFC->FCCOB[5]
+#define FTFx_FCCOB5								FTFC->FCCOB[6]
+#define FTFx_FCCOB4								FTFC->FCCOB[7]
+#define FTFx_FCCOBB								FTFC->FCCOB[8]
+#define FTFx_FCCOBA								FTFC->FCCOB[9]
+#define FTFx_FCCOB9								FTFC->FCCOB[10]
+#define FTFx_FCCOB8								FTFC->FCCOB[11]
+
+#define FTFx_FSTAT_MGSTAT0_MASK					FTFC_FSTAT_MGSTAT0_MASK
+#define FTFx_FSTAT_FPVIOL_MASK					FTFC_FSTAT_FPVIOL_MASK
+#define FTFx_FSTAT_ACCERR_MASK					FTFC_FSTAT_ACCERR_MASK
+#define FTFx_FSTAT_RDCOLERR_MASK				FTFC_FSTAT_RDCOLERR_MASK
+#define FTFx_FSTAT_CCIF_MASK					(sim_ftfc_notify(SIM_FTFC_FSTAT_LAUNCH_MASK))
+#define FTFx_FCNFG_CCIE_MASK					(sim_ftfc_notify(FTFC_FCNFG_CCIE_MASK))
+
+#define CLEAR_FTFx_FSTAT_ERROR_BITS				FTFx_FSTAT &= (uint8_t)(~(FTFx_FSTAT_FPVIOL_MASK | FTFx_FSTAT_ACCERR_MASK | FTFx_FSTAT_RDCOLERR_MASK | FTFx_FSTAT_MGSTAT0_MASK))
+
+#define GET_BIT_0_7(value)						((uint8_t)(((uint32_t)(value)) & 0xFFU))
+#define GET_BIT_8_15(value)						((uint8_t)((((uint32_t)(value)) >> 8) & 0xFFU))
+#define GET_BIT_16_23(value)					((uint8_t)((((uint32_t)(value)) >> 16) & 0xFFU))
+#define GET_BIT_24_31(value)					((uint8_t)(((uint32_t)(value)) >> 24))
+
+// FTFC commands
+#define FTFx_VERIFY_SECTION						0x01U
+#define FTFx_PROGRAM_CHECK						0x02U
+#define FTFx_PROGRAM_PHRASE						0x07U
+#define FTFx_ERASE_SECTOR						0x09U
+#define FTFx_PROGRAM_SECTION					0x0BU
+#define FTFx_PROGRAM_PARTITION					0x80U
+#define FTFx_SET_EERAM							0x81U
+
+#define EEE_ENABLE								(0x00U)
+#define EEE_QUICK_WRITE							(0x55U)
+#define EEE_STATUS_QUERY						(0x77U)
+#define EEE_COMPLETE_INTERRUPT_QUICK_WRITE		(0xAAU)
+#define EEE_DISABLE								(0xFFU)
+
+#define FEATURE_FLS_PF_BLOCK_SECTOR_SIZE		(4096u)
+#define FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE	(8u)
+#define FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT	(16u)
+#define FEATURE_FLS_PF_CHECK_CMD_ADDRESS_ALIGMENT	(4u)
+
+typedef void (* flash_callback_t)(void);
+
+typedef struct
+{
+	uint32_t PFlashBase;
+	uint32_t PFlashSize;
+	uint32_t DFlashBase;
+	uint32_t EERAMBase;
+	flash_callback_t CallBack;
+} flash_user_config_t;
+
+typedef struct
+{
+	uint32_t PFlashBase;
+	uint32_t PFlashSize;
+	uint32_t DFlashBase;
+	uint32_t DFlashSize;
+	uint32_t EERAMBase;
+	uint32_t EEESize;
+	flash_callback_t CallBack;
+} flash_ssd_config_t;
+
+typedef struct
+{
+	uint8_t numOfRecReqMaintain;
+	uint8_t secureEEEStatus;
+	uint16_t brownOutCode;
+	uint16_t sectorEraseCount;
+} flash_eeprom_status_t;
+
+extern const flash_user_config_t Flash_InitConfig0;
+
+status_t FLASH_DRV_Init(const flash_user_config_t * const pUserConf, flash_ssd_config_t * const pSSDConfig);
+void FLASH_DRV_GetPFlashProtection(uint32_t * protectStatus);
+status_t FLASH_DRV_EraseSector(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size);
+status_t FLASH_DRV_Program(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pData);
+status_t FLASH_DRV_ProgramCheck(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pExpectedData,
+								uint32_t * pFailAddr, uint8_t marginLevel);
+status_t FLASH_DRV_VerifySection(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint16_t number, uint8_t marginLevel);
+status_t FLASH_DRV_DEFlashPartition(const flash_ssd_config_t * pSSDConfig, uint8_t uEEEDataSizeCode, uint8_t uDEPartitionCode,
+									uint8_t uCSEcKeySize, bool uSFE, bool flexRamEnableLoadEEEData);
+status_t FLASH_DRV_SetFlexRamFunction(const flash_ssd_config_t * pSSDConfig, uint8_t flexRamFuncCode, uint16_t byteOfQuickWrite,
+									  flash_eeprom_status_t * const pEEPROMStatus);
+status_t FLASH_DRV_EEEWrite(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pData);
+status_t FLASH_DRV_EnableCmdCompleteInterupt(void);
+void FLASH_DRV_DisableCmdCompleteInterupt(void);
+
+#endif /* FLASH_DRIVER_H_ */
@@ -0,0 +1,76 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * Host simulation of the S32K144 parts used by the bootloader (see Host/Makefile).
+ *
+ * The simulated memories are kept in host memory. MEMORY_ADDRESS() (bootloader.h) maps an MCU address
+ * to them by sim_memory_address(), so the bootloader code keeps working with MCU addresses.
+ * 		P-Flash		0x0000_0000 ~ 0x0007_FFFF	file backed, keeps the firmware between runs
+ * 		FlexRAM		0x1400_0000 ~ 0x1400_0FFF	Emulated EEPROM, its backup (FlexNVM) is file backed
+ * 		SRAM		0x1FFF_8000 ~ 0x2000_6FFF
+ *
+ * The CPU is the main thread. The FTFC, LPUART0 and LPIT0 are simulated by threads, which raise
+ * their interrupts as signals on the CPU thread (see sim_irq.c), so an interrupt handler preempts
+ * the thread code like on the MCU. The interrupt priorities and BASEPRI are kept.
+ */
+#define SIM_PFLASH_BASE				(0x00000000u)
+#define SIM_PFLASH_SIZE				(0x00080000u)		// 512 KB
+#define SIM_PFLASH_SECTOR_SIZE		(4096u)
+#define SIM_FLEXRAM_BASE			(0x14000000u)
+#define SIM_FLEXRAM_SIZE			(0x00001000u)		// 4 KB
+#define SIM_SRAM_BASE				(0x1FFF8000u)
+#define SIM_SRAM_SIZE				(0x0000F000u)		// SRAM_L + SRAM_U
+
+/*
+ * The reset vector of the bootloader itself, written into the blank P-Flash at 0x0000_0000.
+ * A jump to it (auto_flash_reset()) restarts the simulated MCU.
+ */
+#define SIM_BOOTLOADER_STACK_POINTER	(0x20007000u)
+#define SIM_BOOTLOADER_RESET_HANDLER	(0x00000411u)
+
+#define SIM_CORE_CLOCK				(80000000u)
+#define SIM_LPUART0_CLOCK			(8000000u)			// SIRC_DIV1
+#define SIM_LPIT0_CLOCK				(8000000u)			// SIRC_DIV1
+
+// sim_main.c
+void sim_fatal(const char * pMessage, uint32_t address);
+void sim_jump(uint32_t stackPointer, uint32_t programCounter);
+void sim_reset(void);
+uint64_t sim_time_ns(void);
+void sim_sleep_ns(uint64_t ns);
+void sim_sleep_until_ns(uint64_t deadline);
+
+// sim_ftfc.c
+bool sim_ftfc_init(const char * pPFlashPath, const char * pFlexNvmPath, double timeScale);
+void sim_ftfc_start(void);
+void sim_ftfc_flush(void);
+uint8_t sim_ftfc_notify(uint8_t mask);
+uintptr_t sim_memory_address(uint32_t address);
+
+// sim_irq.c
+void sim_irq_init(void);
+void sim_irq_set_pending(int32_t irqNumber);
+bool sim_irq_is_busy(int32_t irqNumber);
+void sim_irq_set_exit_hook(int32_t irqNumber, void (* pHook)(void));
+void sim_irq_set_basepri(uint32_t basepri);
+void sim_irq_block_thread(void);
+
+// sim_lpuart.c
+bool sim_lpuart_init(int ptyMasterFd);
+void sim_lpuart_start(void);
+int sim_lpuart_get_pty(void);
+
+// sim_board.c
+void sim_lpit_start(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,171 @@
+/*
+ * sim_board.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "Cpu.h"
+#include "pthread.h"
+#include "sys/prctl.h"
+
+/*
+ * The rest of the board: clocks, pins (the LED on PTE8), the system control block, the reset control module
+ * and the LPIT0 channel 0 timer. The LPIT thread sets the channel 0 interrupt flag every period while the channel runs.
+ */
+
+S32_SCB_Type sim_S32_SCB;
+RCM_Type sim_RCM;
+GPIO_Type sim_PTE;
+
+clock_manager_user_config_t clockManager1_InitConfig0;
+pin_settings_config_t g_pin_mux_InitConfigArr[NUM_OF_CONFIGURED_PINS];
+
+const lpit_user_config_t lpit0_InitConfig =
+{
+	.enableRunInDebug = false,
+	.enableRunInDoze = true
+};
+
+const lpit_user_channel_config_t lpit0_ChnConfig0 =
+{
+	.period = 1600000u,						// 200 ms
+	.isInterruptEnabled = true
+};
+
+static volatile uint32_t sim_lpit_Period = 0u;
+static volatile bool sim_lpit_IsInterruptEnabled = false;
+static volatile bool sim_lpit_IsRunning = false;
+static volatile uint32_t sim_lpit_InterruptFlag = 0u;
+
+static void * sim_lpit_thread(void * pArgument)
+{
+	uint64_t deadline = sim_time_ns();
+
+	(void)pArgument;
+	prctl(PR_SET_TIMERSLACK, 1UL);
+	for(;;)
+	{
+		if( !sim_lpit_IsRunning || (sim_lpit_Period == 0u) )
+		{
+			sim_sleep_ns(1000000u);
+			deadline = sim_time_ns();
+			continue;
+		}
+		deadline += ((uint64_t)sim_lpit_Period * 1000000000ull) / SIM_LPIT0_CLOCK;
+		sim_sleep_until_ns(deadline);
+		if( sim_lpit_IsRunning )
+		{
+			__atomic_or_fetch(&sim_lpit_InterruptFlag, 0x01u, __ATOMIC_SEQ_CST);
+			if( sim_lpit_IsInterruptEnabled )
+			{
+				sim_irq_set_pending(LPIT0_Ch0_IRQn);
+			}
+		}
+	}
+	return NULL;
+}
+
+void sim_lpit_start(void)
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, sim_lpit_thread, NULL);
+}
+
+/*
+ * S32 SDK clock, pins and LPIT drivers
+ */
+status_t CLOCK_DRV_Init(clock_manager_user_config_t const * config)
+{
+	(void)config;
+	return STATUS_SUCCESS;
+}
+
+status_t CLOCK_SYS_GetFreq(clock_names_t clockName, uint32_t * frequency)
+{
+	switch( clockName )
+	{
+		case CORE_CLOCK:		*frequency = SIM_CORE_CLOCK;			break;
+		case BUS_CLOCK:			*frequency = SIM_CORE_CLOCK / 2u;		break;
+		case LPUART0_CLK:		*frequency = SIM_LPUART0_CLOCK;			break;
+		case LPIT0_CLK:			*frequency = SIM_LPIT0_CLOCK;			break;
+		default:				*frequency = 0u;						return STATUS_ERROR;
+	}
+	return STATUS_SUCCESS;
+}
+
+status_t PINS_DRV_Init(uint32_t pinCount, const pin_settings_config_t config[])
+{
+	(void)pinCount;
+	(void)config;
+	return STATUS_SUCCESS;
+}
+
+void PINS_DRV_SetPins(GPIO_Type * const base, uint32_t pins)
+{
+	base->PDOR |= pins;
+}
+
+void PINS_DRV_ClearPins(GPIO_Type * const base, uint32_t pins)
+{
+	base->PDOR &= ~pins;
+}
+
+void PINS_DRV_TogglePins(GPIO_Type * const base, uint32_t pins)
+{
+	base->PDOR ^= pins;
+}
+
+void SystemSoftwareReset(void)
+{
+	sim_reset();
+}
+
+void LPIT_DRV_Init(uint32_t instance, const lpit_user_config_t * userConfig)
+{
+	(void)instance;
+	(void)userConfig;
+	sim_lpit_IsRunning = false;
+	sim_lpit_InterruptFlag = 0u;
+}
+
+status_t LPIT_DRV_InitChannel(uint32_t instance, uint32_t channel, const lpit_user_channel_config_t * userChannelConfig)
+{
+	(void)instance;
+	if( channel != 0u )
+	{
+		return STATUS_ERROR;
+	}
+	sim_lpit_Period = userChannelConfig->period;
+	sim_lpit_IsInterruptEnabled = userChannelConfig->isInterruptEnabled;
+	return STATUS_SUCCESS;
+}
+
+void LPIT_DRV_StartTimerChannels(uint32_t instance, uint32_t mask)
+{
+	(void)instance;
+	if( (mask & 0x01u) != 0u )
+	{
+		sim_lpit_IsRunning = true;
+	}
+}
+
+void LPIT_DRV_StopTimerChannels(uint32_t instance, uint32_t mask)
+{
+	(void)instance;
+	if( (mask & 0x01u) != 0u )
+	{
+		sim_lpit_IsRunning = false;
+	}
+}
+
+uint32_t LPIT_DRV_GetInterruptFlagTimerChannels(uint32_t instance, uint32_t mask)
+{
+	(void)instance;
+	return __atomic_load_n(&sim_lpit_InterruptFlag, __ATOMIC_SEQ_CST) & mask;
+}
+
+void LPIT_DRV_ClearInterruptFlagTimerChannels(uint32_t instance, uint32_t mask)
+{
+	(void)instance;
+	__atomic_and_fetch(&sim_lpit_InterruptFlag, ~mask, __ATOMIC_SEQ_CST);
+}
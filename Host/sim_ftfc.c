@@ -0,0 +1,745 @@
+/*
+ * sim_ftfc.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "Cpu.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "pthread.h"
+#include "sched.h"
+#include "semaphore.h"
+#include "stdio.h"
+#include "string.h"
+#include "sys/mman.h"
+#include "sys/prctl.h"
+#include "time.h"
+#include "unistd.h"
+
+/*
+ * Flash memory module (FTFC) and the simulated memories.
+ *
+ * P-Flash:		512 KB in 4 KB sectors, mapped from the P-Flash file. An erased byte reads 0xFF and programming
+ * 				can only clear bits; programming a phrase which is not erased is reported and gives the AND.
+ * FlexNVM:		not partitioned until the Program Partition command, then 4 KB of Emulated EEPROM whose content
+ * 				is kept in the FlexNVM file (the EEPROM backup).
+ * FlexRAM:		the Emulated EEPROM (EEERDY) or plain RAM (RAMRDY), switched by the Set FlexRAM Function command.
+ * 				The EEPROM writes are taken from FlexRAM into the backup like by the EEE state machine.
+ *
+ * The commands are executed by the FTFC thread from the FCCOB registers, with the typical execution time
+ * of the command scaled by the time scale of the command line (0: no delay). The SDK driver functions below
+ * launch the same commands and wait for CCIF like the SDK does.
+ */
+
+// Typical command execution times in microseconds (approximate S32K144 data sheet values)
+#define SIM_FTFC_TIME_ERASE_SECTOR_US			(12000.0)
+#define SIM_FTFC_TIME_PROGRAM_PHRASE_US			(40.0)
+#define SIM_FTFC_TIME_PROGRAM_SECTION_US		(50.0)		// Command overhead
+#define SIM_FTFC_TIME_SECTION_UNIT_US			(20.0)		// Per 16 bytes
+#define SIM_FTFC_TIME_PROGRAM_CHECK_US			(10.0)		// Per 4 bytes
+#define SIM_FTFC_TIME_VERIFY_SECTION_US			(10.0)		// Command overhead
+#define SIM_FTFC_TIME_EEE_WRITE_US				(360.0)		// Per EEPROM record (up to 4 bytes)
+#define SIM_FTFC_TIME_SET_FLEXRAM_US			(200.0)
+#define SIM_FTFC_TIME_PARTITION_US				(70000.0)
+
+/*
+ * The FTFC thread sleeps until a register write of the bootloader notifies it, then polls the registers
+ * every 10 us for a while, as the notification comes just before the write. A shorter poll interval leaves
+ * no time to the CPU thread (SCHED_IDLE) to do the write on a single host CPU. The timeout only
+ * catches a level interrupt which has not been taken (e.g. disabled while it was pending).
+ */
+#define SIM_FTFC_POLL_NS						(10000u)
+#define SIM_FTFC_POLL_NUM						(100u)
+#define SIM_FTFC_IDLE_TIMEOUT_NS				(1000000L)
+
+// Simulator-internal command: commit the FlexRAM write of FLASH_DRV_EEEWrite() into the EEPROM backup
+#define SIM_FTFC_EEE_WRITE						(0xFEu)
+
+#define SIM_FTFC_FSTAT_ERROR_MASK				(FTFC_FSTAT_MGSTAT0_MASK | FTFC_FSTAT_FPVIOL_MASK | FTFC_FSTAT_ACCERR_MASK | FTFC_FSTAT_RDCOLERR_MASK)
+
+#define SIM_FLEXNVM_NOT_PARTITIONED				(0xFFFFFFFFu)
+
+/*
+ * The flash busy time by kind of command, printed when the simulator stops or restarts
+ * ("sim: flash busy: ..."), e.g. for Tools/download_benchmark.py.
+ */
+typedef enum
+{
+	SIM_FTFC_PHASE_ERASE = 0,
+	SIM_FTFC_PHASE_PROGRAM,
+	SIM_FTFC_PHASE_VERIFY,
+	SIM_FTFC_PHASE_EEPROM,
+	SIM_FTFC_PHASE_OTHER,
+	SIM_FTFC_PHASE_NUM
+} SIM_FTFC_PHASE_t;
+
+// The FlexNVM file
+typedef struct
+{
+	uint32_t	eeeSize;						// SIM_FLEXNVM_NOT_PARTITIONED until Program Partition
+	uint32_t	reserved;
+	uint8_t		eeprom[SIM_FLEXRAM_SIZE];		// The Emulated EEPROM content
+} SIM_FLEXNVM_t;
+
+FTFC_Type sim_FTFC;
+
+const flash_user_config_t Flash_InitConfig0 =
+{
+	.PFlashBase = SIM_PFLASH_BASE,
+	.PFlashSize = SIM_PFLASH_SIZE,
+	.DFlashBase = 0x10000000u,
+	.EERAMBase = SIM_FLEXRAM_BASE,
+	.CallBack = NULL
+};
+
+static uint8_t * sim_ftfc_PFlash = NULL;
+static SIM_FLEXNVM_t * sim_ftfc_pFlexNvm = NULL;
+static uint8_t sim_ftfc_FlexRam[SIM_FLEXRAM_SIZE];
+static uint8_t sim_ftfc_Sram[SIM_SRAM_SIZE];
+static double sim_ftfc_TimeScale = 1.0;
+static uint32_t sim_ftfc_UnerasedProgramCount = 0u;
+static sem_t sim_ftfc_Notification;
+static uint32_t sim_ftfc_PhaseCount[SIM_FTFC_PHASE_NUM];
+static uint64_t sim_ftfc_PhaseTimeNs[SIM_FTFC_PHASE_NUM];
+
+/*
+ * Map a file of the given size, filled with 0xFF when it is created.
+ */
+static void * sim_ftfc_map_file(const char * pPath, size_t size)
+{
+	void * pMemory = NULL;
+	off_t fileSize = 0;
+	uint8_t erased[4096];
+	size_t written = 0;
+	int fd = open(pPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+
+	if( fd < 0 )
+	{
+		perror(pPath);
+		return NULL;
+	}
+	fileSize = lseek(fd, 0, SEEK_END);
+	if( fileSize != (off_t)size )
+	{
+		// New (or foreign) file: erase it
+		memset(erased, 0xFF, sizeof(erased));
+		if( ftruncate(fd, 0) != 0 )
+		{
+			perror(pPath);
+			close(fd);
+			return NULL;
+		}
+		for( written = 0; written < size; written += sizeof(erased) )
+		{
+			size_t chunk = ((size - written) < sizeof(erased)) ? (size - written) : sizeof(erased);
+			if( pwrite(fd, erased, chunk, (off_t)written) != (ssize_t)chunk )
+			{
+				perror(pPath);
+				close(fd);
+				return NULL;
+			}
+		}
+	}
+	pMemory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if( pMemory == MAP_FAILED )
+	{
+		perror(pPath);
+		return NULL;
+	}
+	return pMemory;
+}
+
+static void sim_ftfc_delay(double microseconds)
+{
+	if( sim_ftfc_TimeScale > 0.0 )
+	{
+		sim_sleep_ns((uint64_t)(microseconds * sim_ftfc_TimeScale * 1000.0));
+	}
+}
+
+// Called by the FTFC thread and by the CPU thread (the check commands of the SDK driver)
+static void sim_ftfc_account(SIM_FTFC_PHASE_t phase, uint64_t startTime)
+{
+	__atomic_add_fetch(&sim_ftfc_PhaseCount[phase], 1u, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&sim_ftfc_PhaseTimeNs[phase], sim_time_ns() - startTime, __ATOMIC_RELAXED);
+}
+
+static SIM_FTFC_PHASE_t sim_ftfc_get_phase(uint8_t command)
+{
+	switch( command )
+	{
+		case FTFx_ERASE_SECTOR:			return SIM_FTFC_PHASE_ERASE;
+		case FTFx_VERIFY_SECTION:		return SIM_FTFC_PHASE_VERIFY;
+		case FTFx_PROGRAM_PHRASE:
+		case FTFx_PROGRAM_SECTION:		return SIM_FTFC_PHASE_PROGRAM;
+		case SIM_FTFC_EEE_WRITE:		return SIM_FTFC_PHASE_EEPROM;
+		default:						return SIM_FTFC_PHASE_OTHER;
+	}
+}
+
+static bool sim_ftfc_is_partitioned(void)
+{
+	return (sim_ftfc_pFlexNvm->eeeSize != SIM_FLEXNVM_NOT_PARTITIONED);
+}
+
+/*
+ * Take the FlexRAM writes into the EEPROM backup.
+ * @return:
+ * 		the number of EEPROM records (4 bytes) written
+ */
+static uint32_t sim_ftfc_commit_eeprom(void)
+{
+	uint32_t i = 0;
+	uint32_t recordNum = 0;
+
+	for( i = 0; i < sim_ftfc_pFlexNvm->eeeSize; i += 4u )
+	{
+		if( memcmp(&sim_ftfc_FlexRam[i], &sim_ftfc_pFlexNvm->eeprom[i], 4u) != 0 )
+		{
+			memcpy(&sim_ftfc_pFlexNvm->eeprom[i], &sim_ftfc_FlexRam[i], 4u);
+			recordNum++;
+		}
+	}
+	return recordNum;
+}
+
+static void sim_ftfc_enable_eee(void)
+{
+	memset(sim_ftfc_FlexRam, 0xFF, sizeof(sim_ftfc_FlexRam));
+	memcpy(sim_ftfc_FlexRam, sim_ftfc_pFlexNvm->eeprom, sim_ftfc_pFlexNvm->eeeSize);
+	FTFC->FCNFG = (uint8_t)((FTFC->FCNFG & ~FTFC_FCNFG_RAMRDY_MASK) | FTFC_FCNFG_EEERDY_MASK);
+}
+
+/*
+ * Program P-Flash bytes. Programming can only clear bits.
+ */
+static void sim_ftfc_program(uint32_t address, const volatile uint8_t * pData, uint32_t byteNum)
+{
+	uint32_t i = 0;
+	bool isErased = true;
+
+	for( i = 0; i < byteNum; i++ )
+	{
+		if( (sim_ftfc_PFlash[address + i] & pData[i]) != pData[i] )
+		{
+			isErased = false;
+		}
+		sim_ftfc_PFlash[address + i] &= pData[i];
+	}
+	if( !isErased )
+	{
+		sim_ftfc_UnerasedProgramCount++;
+		fprintf(stderr, "sim: P-Flash 0x%08X programmed without erase\n", (unsigned)address);
+	}
+}
+
+/*
+ * Execute the command in the FCCOB registers.
+ * @return:
+ * 		the FSTAT error flags
+ */
+static uint8_t sim_ftfc_execute(void)
+{
+	uint8_t command = FTFx_FCCOB0;
+	uint32_t address = ((uint32_t)FTFx_FCCOB1 << 16) | ((uint32_t)FTFx_FCCOB2 << 8) | (uint32_t)FTFx_FCCOB3;
+	uint32_t byteNum = 0;
+	uint32_t recordNum = 0;
+	uint32_t i = 0;
+
+	switch( command )
+	{
+		case FTFx_PROGRAM_PHRASE:
+			if( ((address % FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) != 0u) || ((address + FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) > SIM_PFLASH_SIZE) )
+			{
+				return FTFC_FSTAT_ACCERR_MASK;
+			}
+			sim_ftfc_delay(SIM_FTFC_TIME_PROGRAM_PHRASE_US);
+			// The phrase is loaded into FCCOB4...FCCOBB, in memory order from FTFx_BASE + 8
+			sim_ftfc_program(address, &FTFC->FCCOB[4], FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE);
+			return 0u;
+
+		case FTFx_PROGRAM_SECTION:
+			byteNum = (((uint32_t)FTFx_FCCOB4 << 8) | (uint32_t)FTFx_FCCOB5) * FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT;
+			if( ((FTFC->FCNFG & FTFC_FCNFG_RAMRDY_MASK) == 0u) || (byteNum == 0u) || (byteNum > SIM_FLEXRAM_SIZE) ||
+				((address % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) != 0u) || ((address + byteNum) > SIM_PFLASH_SIZE) )
+			{
+				return FTFC_FSTAT_ACCERR_MASK;
+			}
+			sim_ftfc_delay(SIM_FTFC_TIME_PROGRAM_SECTION_US + (SIM_FTFC_TIME_SECTION_UNIT_US * (double)(byteNum / FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT)));
+			sim_ftfc_program(address, sim_ftfc_FlexRam, byteNum);
+			return 0u;
+
+		case FTFx_ERASE_SECTOR:
+			if( ((address % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) != 0u) || (address >= SIM_PFLASH_SIZE) )
+			{
+				return FTFC_FSTAT_ACCERR_MASK;
+			}
+			sim_ftfc_delay(SIM_FTFC_TIME_ERASE_SECTOR_US);
+			memset(&sim_ftfc_PFlash[address - (address % SIM_PFLASH_SECTOR_SIZE)], 0xFF, SIM_PFLASH_SECTOR_SIZE);
+			return 0u;
+
+		case FTFx_VERIFY_SECTION:
+			byteNum = (((uint32_t)FTFx_FCCOB4 << 8) | (uint32_t)FTFx_FCCOB5) * FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT;
+			if( (byteNum == 0u) || ((address % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) != 0u) || ((address + byteNum) > SIM_PFLASH_SIZE) )
+			{
+				return FTFC_FSTAT_ACCERR_MASK;
+			}
+			sim_ftfc_delay(SIM_FTFC_TIME_VERIFY_SECTION_US);
+			for( i = 0; i < byteNum; i++ )
+			{
+				if( sim_ftfc_PFlash[address + i] != 0xFFu )
+				{
+					return FTFC_FSTAT_MGSTAT0_MASK;
+				}
+			}
+			return 0u;
+
+		case FTFx_PROGRAM_PARTITION:
+			if( sim_ftfc_is_partitioned() )
+			{
+				// The IFR has been programmed already
+				return FTFC_FSTAT_ACCERR_MASK;
+			}
+			// EEPROM data size code 0x02: 4 KB, 0x03: 2 KB, 0x04: 1 KB, 0x0F: none
+			switch( FTFx_FCCOB4 & 0x0Fu )
+			{
+				case 0x02u:		sim_ftfc_pFlexNvm->eeeSize = 4096u;		break;
+				case 0x03u:		sim_ftfc_pFlexNvm->eeeSize = 2048u;		break;
+				case 0x04u:		sim_ftfc_pFlexNvm->eeeSize = 1024u;		break;
+				case 0x0Fu:		sim_ftfc_pFlexNvm->eeeSize = 0u;		break;
+				default:		return FTFC_FSTAT_ACCERR_MASK;
+			}
+			sim_ftfc_delay(SIM_FTFC_TIME_PARTITION_US);
+			memset(sim_ftfc_pFlexNvm->eeprom, 0xFF, sizeof(sim_ftfc_pFlexNvm->eeprom));
+			return 0u;
+
+		case FTFx_SET_EERAM:
+			if( FTFx_FCCOB1 == EEE_ENABLE )
+			{
+				if( !sim_ftfc_is_partitioned() || (sim_ftfc_pFlexNvm->eeeSize == 0u) )
+				{
+					return FTFC_FSTAT_ACCERR_MASK;
+				}
+				sim_ftfc_delay(SIM_FTFC_TIME_SET_FLEXRAM_US);
+				sim_ftfc_enable_eee();
+				return 0u;
+			}
+			if( FTFx_FCCOB1 == EEE_DISABLE )
+			{
+				if( (FTFC->FCNFG & FTFC_FCNFG_EEERDY_MASK) != 0u )
+				{
+					(void)sim_ftfc_commit_eeprom();
+				}
+				sim_ftfc_delay(SIM_FTFC_TIME_SET_FLEXRAM_US);
+				FTFC->FCNFG = (uint8_t)((FTFC->FCNFG & ~FTFC_FCNFG_EEERDY_MASK) | FTFC_FCNFG_RAMRDY_MASK);
+				return 0u;
+			}
+			return FTFC_FSTAT_ACCERR_MASK;
+
+		case SIM_FTFC_EEE_WRITE:
+			recordNum = sim_ftfc_commit_eeprom();
+			sim_ftfc_delay(SIM_FTFC_TIME_EEE_WRITE_US * (double)recordNum);
+			return 0u;
+
+		default:
+			return FTFC_FSTAT_ACCERR_MASK;
+	}
+}
+
+/*
+ * FTFC thread: executes the launched commands and raises the command complete interrupt.
+ */
+static void * sim_ftfc_thread(void * pArgument)
+{
+	uint8_t fstat = 0;
+	uint8_t error = 0;
+	uint32_t pollCount = 0;
+	uint64_t startTime = 0;
+	struct timespec timeout;
+
+	(void)pArgument;
+	prctl(PR_SET_TIMERSLACK, 1UL);
+	for(;;)
+	{
+		fstat = FTFC->FSTAT;
+		if( (fstat & SIM_FTFC_FSTAT_LAUNCH_MASK) != 0u )
+		{
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			startTime = sim_time_ns();
+			error = sim_ftfc_execute();
+			sim_ftfc_account(sim_ftfc_get_phase(FTFx_FCCOB0), startTime);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			FTFC->FSTAT = (uint8_t)(FTFC_FSTAT_CCIF_MASK | error);
+			pollCount = SIM_FTFC_POLL_NUM;
+			continue;
+		}
+		if( ((fstat & FTFC_FSTAT_CCIF_MASK) != 0u) && ((FTFC->FCNFG & FTFC_FCNFG_CCIE_MASK) != 0u) &&
+			!sim_irq_is_busy(FTFC_IRQn) )
+		{
+			// CCIF with CCIE is a level: the interrupt is requested again until the handler launches or disables it.
+			sim_irq_set_pending(FTFC_IRQn);
+			pollCount = SIM_FTFC_POLL_NUM;
+			continue;
+		}
+
+		if( pollCount < SIM_FTFC_POLL_NUM )
+		{
+			// The notified register write follows the notification.
+			pollCount++;
+			sim_sleep_ns(SIM_FTFC_POLL_NS);
+		}
+		else
+		{
+			clock_gettime(CLOCK_REALTIME, &timeout);
+			timeout.tv_nsec += SIM_FTFC_IDLE_TIMEOUT_NS;
+			if( timeout.tv_nsec >= 1000000000L )
+			{
+				timeout.tv_sec++;
+				timeout.tv_nsec -= 1000000000L;
+			}
+			if( sem_timedwait(&sim_ftfc_Notification, &timeout) == 0 )
+			{
+				pollCount = 0u;
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Called in the FTFC register writes of the bootloader which start something (see flash_driver.h).
+ * Async-signal-safe, the interrupt handlers launch the commands.
+ * @return:
+ * 		the mask to write
+ */
+uint8_t sim_ftfc_notify(uint8_t mask)
+{
+	sem_post(&sim_ftfc_Notification);
+	return mask;
+}
+
+/*
+ * Map the memories and reset the FTFC.
+ * @param:
+ * 		pPFlashPath, pFlexNvmPath: the files keeping the P-Flash and the FlexNVM (EEPROM)
+ * 		timeScale: the factor of the command execution times
+ */
+bool sim_ftfc_init(const char * pPFlashPath, const char * pFlexNvmPath, double timeScale)
+{
+	uint32_t * pVector = NULL;
+
+	sim_ftfc_TimeScale = timeScale;
+	sim_ftfc_PFlash = (uint8_t *)sim_ftfc_map_file(pPFlashPath, SIM_PFLASH_SIZE);
+	sim_ftfc_pFlexNvm = (SIM_FLEXNVM_t *)sim_ftfc_map_file(pFlexNvmPath, sizeof(SIM_FLEXNVM_t));
+	if( (sim_ftfc_PFlash == NULL) || (sim_ftfc_pFlexNvm == NULL) )
+	{
+		return false;
+	}
+	if( sim_ftfc_is_partitioned() && (sim_ftfc_pFlexNvm->eeeSize > SIM_FLEXRAM_SIZE) )
+	{
+		fprintf(stderr, "sim: %s is not a FlexNVM file\n", pFlexNvmPath);
+		return false;
+	}
+
+	// The bootloader itself is not in the simulated P-Flash, only its vector table for auto_flash_reset().
+	pVector = (uint32_t *)sim_ftfc_PFlash;
+	if( (pVector[0] == 0xFFFFFFFFu) && (pVector[1] == 0xFFFFFFFFu) )
+	{
+		pVector[0] = SIM_BOOTLOADER_STACK_POINTER;
+		pVector[1] = SIM_BOOTLOADER_RESET_HANDLER;
+	}
+
+	// Reset: the FlexRAM is loaded with the EEPROM if it is partitioned
+	memset(&sim_FTFC, 0, sizeof(sim_FTFC));
+	FTFC->FSTAT = FTFC_FSTAT_CCIF_MASK;
+	if( sim_ftfc_is_partitioned() && (sim_ftfc_pFlexNvm->eeeSize != 0u) )
+	{
+		sim_ftfc_enable_eee();
+	}
+	else
+	{
+		memset(sim_ftfc_FlexRam, 0xFF, sizeof(sim_ftfc_FlexRam));
+		FTFC->FCNFG = FTFC_FCNFG_RAMRDY_MASK;
+	}
+	return true;
+}
+
+void sim_ftfc_start(void)
+{
+	pthread_t thread;
+	sem_init(&sim_ftfc_Notification, 0, 0u);
+	pthread_create(&thread, NULL, sim_ftfc_thread, NULL);
+}
+
+/*
+ * Complete the EEPROM writes started by the CPU (e.g. written to FlexRAM directly),
+ * before the simulator stops or restarts.
+ */
+void sim_ftfc_flush(void)
+{
+	if( (sim_ftfc_pFlexNvm != NULL) && ((FTFC->FCNFG & FTFC_FCNFG_EEERDY_MASK) != 0u) )
+	{
+		(void)sim_ftfc_commit_eeprom();
+	}
+	if( sim_ftfc_UnerasedProgramCount != 0u )
+	{
+		fprintf(stderr, "sim: %u phrases programmed without erase\n", (unsigned)sim_ftfc_UnerasedProgramCount);
+	}
+	printf("sim: flash busy: erase %u x %.3f ms, program %u x %.3f ms, verify %u x %.3f ms, eeprom %u x %.3f ms\n",
+		   (unsigned)sim_ftfc_PhaseCount[SIM_FTFC_PHASE_ERASE], (double)sim_ftfc_PhaseTimeNs[SIM_FTFC_PHASE_ERASE] / 1e6,
+		   (unsigned)sim_ftfc_PhaseCount[SIM_FTFC_PHASE_PROGRAM], (double)sim_ftfc_PhaseTimeNs[SIM_FTFC_PHASE_PROGRAM] / 1e6,
+		   (unsigned)sim_ftfc_PhaseCount[SIM_FTFC_PHASE_VERIFY], (double)sim_ftfc_PhaseTimeNs[SIM_FTFC_PHASE_VERIFY] / 1e6,
+		   (unsigned)sim_ftfc_PhaseCount[SIM_FTFC_PHASE_EEPROM], (double)sim_ftfc_PhaseTimeNs[SIM_FTFC_PHASE_EEPROM] / 1e6);
+}
+
+/*
+ * @return:
+ * 		the host address of an MCU memory address, see MEMORY_ADDRESS()
+ */
+uintptr_t sim_memory_address(uint32_t address)
+{
+	// The end address of an area is accepted too
+	if( address <= (SIM_PFLASH_BASE + SIM_PFLASH_SIZE) )
+	{
+		return (uintptr_t)&sim_ftfc_PFlash[address - SIM_PFLASH_BASE];
+	}
+	if( (address >= SIM_FLEXRAM_BASE) && (address <= (SIM_FLEXRAM_BASE + SIM_FLEXRAM_SIZE)) )
+	{
+		return (uintptr_t)&sim_ftfc_FlexRam[address - SIM_FLEXRAM_BASE];
+	}
+	if( (address >= SIM_SRAM_BASE) && (address <= (SIM_SRAM_BASE + SIM_SRAM_SIZE)) )
+	{
+		return (uintptr_t)&sim_ftfc_Sram[address - SIM_SRAM_BASE];
+	}
+	sim_fatal("access outside the simulated memories", address);
+	return 0u;
+}
+
+/*
+ * Launch the command loaded into FCCOB and wait for its completion, like the SDK driver.
+ */
+static status_t sim_ftfc_command(void)
+{
+	while( (FTFC->FSTAT & FTFC_FSTAT_CCIF_MASK) == 0u )
+	{
+		sched_yield();
+	}
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	FTFx_FSTAT = FTFx_FSTAT_CCIF_MASK;
+	while( (FTFC->FSTAT & FTFC_FSTAT_CCIF_MASK) == 0u )
+	{
+		sched_yield();
+	}
+	return ((FTFC->FSTAT & SIM_FTFC_FSTAT_ERROR_MASK) != 0u) ? STATUS_ERROR : STATUS_SUCCESS;
+}
+
+static void sim_ftfc_load_address(uint8_t command, uint32_t address)
+{
+	FTFx_FCCOB0 = command;
+	FTFx_FCCOB1 = GET_BIT_16_23(address);
+	FTFx_FCCOB2 = GET_BIT_8_15(address);
+	FTFx_FCCOB3 = GET_BIT_0_7(address);
+}
+
+/*
+ * S32 SDK flash driver
+ */
+status_t FLASH_DRV_Init(const flash_user_config_t * const pUserConf, flash_ssd_config_t * const pSSDConfig)
+{
+	pSSDConfig->PFlashBase = pUserConf->PFlashBase;
+	pSSDConfig->PFlashSize = SIM_PFLASH_SIZE;
+	pSSDConfig->DFlashBase = pUserConf->DFlashBase;
+	pSSDConfig->EERAMBase = pUserConf->EERAMBase;
+	pSSDConfig->CallBack = pUserConf->CallBack;
+	if( sim_ftfc_is_partitioned() )
+	{
+		// Partition code 0x08: the whole 64 KB FlexNVM is the EEPROM backup
+		pSSDConfig->DFlashSize = 0u;
+		pSSDConfig->EEESize = sim_ftfc_pFlexNvm->eeeSize;
+	}
+	else
+	{
+		pSSDConfig->DFlashSize = 0u;
+		pSSDConfig->EEESize = 0u;
+	}
+	return STATUS_SUCCESS;
+}
+
+void FLASH_DRV_GetPFlashProtection(uint32_t * protectStatus)
+{
+	*protectStatus = 0xFFFFFFFFu;
+}
+
+status_t FLASH_DRV_EraseSector(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size)
+{
+	status_t status = STATUS_SUCCESS;
+	uint32_t address = dest - pSSDConfig->PFlashBase;
+
+	if( ((address % FEATURE_FLS_PF_BLOCK_SECTOR_SIZE) != 0u) || ((size % FEATURE_FLS_PF_BLOCK_SECTOR_SIZE) != 0u) )
+	{
+		return STATUS_ERROR;
+	}
+	while( (size > 0u) && (status == STATUS_SUCCESS) )
+	{
+		sim_ftfc_load_address(FTFx_ERASE_SECTOR, address);
+		status = sim_ftfc_command();
+		address += FEATURE_FLS_PF_BLOCK_SECTOR_SIZE;
+		size -= FEATURE_FLS_PF_BLOCK_SECTOR_SIZE;
+	}
+	return status;
+}
+
+status_t FLASH_DRV_Program(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pData)
+{
+	status_t status = STATUS_SUCCESS;
+	uint32_t address = dest - pSSDConfig->PFlashBase;
+	uint32_t i = 0;
+
+	if( (size % FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) != 0u )
+	{
+		return STATUS_UNSUPPORTED;
+	}
+	while( (size > 0u) && (status == STATUS_SUCCESS) )
+	{
+		sim_ftfc_load_address(FTFx_PROGRAM_PHRASE, address);
+		for( i = 0; i < FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE; i++ )
+		{
+			*(volatile uint8_t *)(FTFx_BASE + i + 0x08u) = pData[i];
+		}
+		status = sim_ftfc_command();
+		address += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+		pData += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+		size -= FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+	}
+	return status;
+}
+
+status_t FLASH_DRV_ProgramCheck(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pExpectedData,
+								uint32_t * pFailAddr, uint8_t marginLevel)
+{
+	uint32_t offset = 0;
+	uint64_t startTime = sim_time_ns();
+	status_t status = STATUS_SUCCESS;
+
+	(void)pSSDConfig;
+	(void)marginLevel;
+	if( ((dest % FEATURE_FLS_PF_CHECK_CMD_ADDRESS_ALIGMENT) != 0u) || ((size % FEATURE_FLS_PF_CHECK_CMD_ADDRESS_ALIGMENT) != 0u) ||
+		((dest + size) > SIM_PFLASH_SIZE) )
+	{
+		return STATUS_ERROR;
+	}
+	for( offset = 0; (offset < size) && (status == STATUS_SUCCESS); offset += FEATURE_FLS_PF_CHECK_CMD_ADDRESS_ALIGMENT )
+	{
+		sim_ftfc_delay(SIM_FTFC_TIME_PROGRAM_CHECK_US);
+		if( memcmp(&sim_ftfc_PFlash[dest + offset], &pExpectedData[offset], FEATURE_FLS_PF_CHECK_CMD_ADDRESS_ALIGMENT) != 0 )
+		{
+			*pFailAddr = dest + offset;
+			status = STATUS_ERROR;
+		}
+	}
+	sim_ftfc_account(SIM_FTFC_PHASE_VERIFY, startTime);
+	return status;
+}
+
+status_t FLASH_DRV_VerifySection(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint16_t number, uint8_t marginLevel)
+{
+	uint32_t byteNum = (uint32_t)number * FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT;
+	uint32_t i = 0;
+	uint64_t startTime = sim_time_ns();
+	status_t status = STATUS_SUCCESS;
+
+	(void)pSSDConfig;
+	(void)marginLevel;
+	if( ((dest % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) != 0u) || ((dest + byteNum) > SIM_PFLASH_SIZE) )
+	{
+		return STATUS_ERROR;
+	}
+	sim_ftfc_delay(SIM_FTFC_TIME_VERIFY_SECTION_US);
+	for( i = 0; (i < byteNum) && (status == STATUS_SUCCESS); i++ )
+	{
+		if( sim_ftfc_PFlash[dest + i] != 0xFFu )
+		{
+			status = STATUS_ERROR;
+		}
+	}
+	sim_ftfc_account(SIM_FTFC_PHASE_VERIFY, startTime);
+	return status;
+}
+
+status_t FLASH_DRV_DEFlashPartition(const flash_ssd_config_t * pSSDConfig, uint8_t uEEEDataSizeCode, uint8_t uDEPartitionCode,
+									uint8_t uCSEcKeySize, bool uSFE, bool flexRamEnableLoadEEEData)
+{
+	(void)pSSDConfig;
+	FTFx_FCCOB0 = FTFx_PROGRAM_PARTITION;
+	FTFx_FCCOB1 = uCSEcKeySize;
+	FTFx_FCCOB2 = (uint8_t)(uSFE ? 1u : 0u);
+	FTFx_FCCOB3 = (uint8_t)(flexRamEnableLoadEEEData ? 0u : 1u);
+	FTFx_FCCOB4 = uEEEDataSizeCode;
+	FTFx_FCCOB5 = uDEPartitionCode;
+	return sim_ftfc_command();
+}
+
+status_t FLASH_DRV_SetFlexRamFunction(const flash_ssd_config_t * pSSDConfig, uint8_t flexRamFuncCode, uint16_t byteOfQuickWrite,
+									  flash_eeprom_status_t * const pEEPROMStatus)
+{
+	(void)pSSDConfig;
+	(void)byteOfQuickWrite;
+	(void)pEEPROMStatus;
+	FTFx_FCCOB0 = FTFx_SET_EERAM;
+	FTFx_FCCOB1 = flexRamFuncCode;
+	return sim_ftfc_command();
+}
+
+/*
+ * Write the EEPROM through FlexRAM, one record (up to 4 aligned bytes) at a time.
+ */
+status_t FLASH_DRV_EEEWrite(const flash_ssd_config_t * pSSDConfig, uint32_t dest, uint32_t size, const uint8_t * pData)
+{
+	status_t status = STATUS_SUCCESS;
+	uint32_t offset = dest - pSSDConfig->EERAMBase;
+	uint32_t recordSize = 0;
+
+	if( (FTFC->FCNFG & FTFC_FCNFG_EEERDY_MASK) == 0u )
+	{
+		return STATUS_UNSUPPORTED;
+	}
+	if( (dest < pSSDConfig->EERAMBase) || ((dest + size) > (pSSDConfig->EERAMBase + pSSDConfig->EEESize)) )
+	{
+		return STATUS_ERROR;
+	}
+	while( (size > 0u) && (status == STATUS_SUCCESS) )
+	{
+		if( ((offset % 4u) == 0u) && (size >= 4u) )
+		{
+			recordSize = 4u;
+		}
+		else if( ((offset % 2u) == 0u) && (size >= 2u) )
+		{
+			recordSize = 2u;
+		}
+		else
+		{
+			recordSize = 1u;
+		}
+		memcpy(&sim_ftfc_FlexRam[offset], pData, recordSize);
+		FTFx_FCCOB0 = SIM_FTFC_EEE_WRITE;
+		status = sim_ftfc_command();
+		offset += recordSize;
+		pData += recordSize;
+		size -= recordSize;
+	}
+	return status;
+}
+
+status_t FLASH_DRV_EnableCmdCompleteInterupt(void)
+{
+	FTFx_FCNFG |= FTFx_FCNFG_CCIE_MASK;
+	return STATUS_SUCCESS;
+}
+
+void FLASH_DRV_DisableCmdCompleteInterupt(void)
+{
+	FTFx_FCNFG &= (uint8_t)(~FTFx_FCNFG_CCIE_MASK);
+}
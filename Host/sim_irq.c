@@ -0,0 +1,313 @@
+/*
+ * sim_irq.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "Cpu.h"
+#include "errno.h"
+#include "pthread.h"
+#include "signal.h"
+#include "string.h"
+
+/*
+ * NVIC model.
+ *
+ * Every simulated interrupt is a real-time signal to the CPU thread. The signal handler calls the installed
+ * interrupt handler, so it preempts the thread code like an exception on the MCU.
+ * An interrupt stays pending while it is disabled, while the interrupts are disabled globally (PRIMASK),
+ * while it is masked by BASEPRI, or while a handler of the same or a more urgent priority runs.
+ * The device threads set the pending flag and send the signal; the level-triggered sources (FTFC CCIF)
+ * check sim_irq_is_busy() to raise their interrupt again only after the handler has returned.
+ */
+
+typedef struct
+{
+	IRQn_Type			irqNumber;
+	isr_t				handler;
+	void				(* pExitHook)(void);		// Called after the handler, e.g. to clear a status flag read by the handler
+	uint8_t				priority;
+	volatile bool		isEnabled;
+	volatile bool		isPending;
+	volatile bool		isActive;
+} SIM_IRQ_t;
+
+#define SIM_IRQ_NUM					(3u)
+#define SIM_IRQ_SIGNAL(index)		(SIGRTMIN + (int)(index))
+#define SIM_IRQ_NO_PRIORITY			(0xFFu)
+
+extern void FTFC_IRQHandler(void);
+extern void LPUART0_RxTx_IRQHandler(void);
+extern void LPIT0_Ch0_IRQHandler(void);
+
+static SIM_IRQ_t sim_Irq[SIM_IRQ_NUM] =
+{
+	{ .irqNumber = FTFC_IRQn,			.handler = FTFC_IRQHandler },
+	{ .irqNumber = LPUART0_RxTx_IRQn,	.handler = LPUART0_RxTx_IRQHandler },
+	{ .irqNumber = LPIT0_Ch0_IRQn,		.handler = LPIT0_Ch0_IRQHandler },
+};
+
+static pthread_t sim_irq_CpuThread;
+static volatile bool sim_irq_IsGlobalEnabled = true;		// PRIMASK is cleared at reset
+static volatile uint32_t sim_irq_Basepri = 0u;
+static volatile uint8_t sim_irq_ActivePriority = SIM_IRQ_NO_PRIORITY;
+
+static SIM_IRQ_t * sim_irq_find(int32_t irqNumber)
+{
+	uint32_t i = 0;
+	for( i = 0; i < SIM_IRQ_NUM; i++ )
+	{
+		if( (int32_t)sim_Irq[i].irqNumber == irqNumber )
+		{
+			return &sim_Irq[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Is the interrupt of the priority masked by PRIMASK, BASEPRI or the running handler?
+ */
+static bool sim_irq_is_masked(uint8_t priority)
+{
+	if( !sim_irq_IsGlobalEnabled )
+	{
+		return true;
+	}
+	if( (sim_irq_Basepri != 0u) && (((uint32_t)priority << (8u - FEATURE_NVIC_PRIO_BITS)) >= sim_irq_Basepri) )
+	{
+		return true;
+	}
+	return (priority >= sim_irq_ActivePriority);
+}
+
+/*
+ * Apply the masking to the signal mask of the CPU thread.
+ * Called on the CPU thread only.
+ */
+static void sim_irq_update_mask(void)
+{
+	sigset_t mask;
+	uint32_t i = 0;
+
+	sigemptyset(&mask);
+	for( i = 0; i < SIM_IRQ_NUM; i++ )
+	{
+		if( sim_irq_is_masked(sim_Irq[i].priority) )
+		{
+			sigaddset(&mask, SIM_IRQ_SIGNAL(i));
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &mask, NULL);
+}
+
+static void sim_irq_signal_handler(int signalNumber)
+{
+	SIM_IRQ_t * pIrq = &sim_Irq[signalNumber - SIGRTMIN];
+	uint8_t preemptedPriority = sim_irq_ActivePriority;
+	int savedErrno = errno;
+
+	if( !pIrq->isEnabled || !__atomic_load_n(&pIrq->isPending, __ATOMIC_SEQ_CST) )
+	{
+		// Disabled (served when it is enabled again) or already served by an earlier signal
+		return;
+	}
+	__atomic_store_n(&pIrq->isActive, true, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&pIrq->isPending, false, __ATOMIC_SEQ_CST);
+	sim_irq_ActivePriority = pIrq->priority;
+
+	pIrq->handler();
+	if( pIrq->pExitHook != NULL )
+	{
+		pIrq->pExitHook();
+	}
+
+	sim_irq_ActivePriority = preemptedPriority;
+	__atomic_store_n(&pIrq->isActive, false, __ATOMIC_SEQ_CST);
+	errno = savedErrno;
+}
+
+/*
+ * Install the signal handlers. A handler blocks the interrupts of the same or a lower priority.
+ */
+static void sim_irq_install_signals(void)
+{
+	struct sigaction action;
+	uint32_t i = 0;
+	uint32_t j = 0;
+
+	for( i = 0; i < SIM_IRQ_NUM; i++ )
+	{
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = sim_irq_signal_handler;
+		action.sa_flags = SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		for( j = 0; j < SIM_IRQ_NUM; j++ )
+		{
+			if( sim_Irq[j].priority >= sim_Irq[i].priority )
+			{
+				sigaddset(&action.sa_mask, SIM_IRQ_SIGNAL(j));
+			}
+		}
+		sigaction(SIM_IRQ_SIGNAL(i), &action, NULL);
+	}
+}
+
+/*
+ * Called on the CPU thread before the device threads are started.
+ */
+void sim_irq_init(void)
+{
+	sim_irq_CpuThread = pthread_self();
+	sim_irq_install_signals();
+	sim_irq_update_mask();
+}
+
+/*
+ * Block the interrupt signals on the calling thread, e.g. before the simulator restarts itself.
+ */
+void sim_irq_block_thread(void)
+{
+	sigset_t mask;
+	uint32_t i = 0;
+
+	sigemptyset(&mask);
+	for( i = 0; i < SIM_IRQ_NUM; i++ )
+	{
+		sigaddset(&mask, SIM_IRQ_SIGNAL(i));
+	}
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+}
+
+/*
+ * Request the interrupt, from any thread.
+ */
+void sim_irq_set_pending(int32_t irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq == NULL )
+	{
+		return;
+	}
+	__atomic_store_n(&pIrq->isPending, true, __ATOMIC_SEQ_CST);
+	pthread_kill(sim_irq_CpuThread, SIM_IRQ_SIGNAL(pIrq - sim_Irq));
+}
+
+/*
+ * @return:
+ * 		true while the interrupt is pending or its handler runs
+ */
+bool sim_irq_is_busy(int32_t irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq == NULL )
+	{
+		return false;
+	}
+	return __atomic_load_n(&pIrq->isPending, __ATOMIC_SEQ_CST) || __atomic_load_n(&pIrq->isActive, __ATOMIC_SEQ_CST);
+}
+
+void sim_irq_set_exit_hook(int32_t irqNumber, void (* pHook)(void))
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq != NULL )
+	{
+		pIrq->pExitHook = pHook;
+	}
+}
+
+void sim_irq_set_basepri(uint32_t basepri)
+{
+	sim_irq_Basepri = basepri & 0xFFu;
+	sim_irq_update_mask();
+}
+
+/*
+ * S32 SDK interrupt manager
+ */
+void INT_SYS_InstallHandler(IRQn_Type irqNumber, const isr_t newHandler, isr_t * const oldHandler)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq == NULL )
+	{
+		return;
+	}
+	if( oldHandler != NULL )
+	{
+		*oldHandler = pIrq->handler;
+	}
+	pIrq->handler = newHandler;
+}
+
+void INT_SYS_EnableIRQ(IRQn_Type irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq == NULL )
+	{
+		return;
+	}
+	pIrq->isEnabled = true;
+	if( __atomic_load_n(&pIrq->isPending, __ATOMIC_SEQ_CST) )
+	{
+		pthread_kill(sim_irq_CpuThread, SIM_IRQ_SIGNAL(pIrq - sim_Irq));
+	}
+}
+
+void INT_SYS_DisableIRQ(IRQn_Type irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq != NULL )
+	{
+		pIrq->isEnabled = false;
+	}
+}
+
+void INT_SYS_EnableIRQGlobal(void)
+{
+	sim_irq_IsGlobalEnabled = true;
+	sim_irq_update_mask();
+}
+
+void INT_SYS_DisableIRQGlobal(void)
+{
+	sim_irq_IsGlobalEnabled = false;
+	sim_irq_update_mask();
+}
+
+void INT_SYS_SetPriority(IRQn_Type irqNumber, uint8_t priority)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq == NULL )
+	{
+		return;
+	}
+	pIrq->priority = priority & ((1u << FEATURE_NVIC_PRIO_BITS) - 1u);
+	sim_irq_install_signals();
+	sim_irq_update_mask();
+}
+
+uint8_t INT_SYS_GetPriority(IRQn_Type irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	return (pIrq != NULL) ? pIrq->priority : 0u;
+}
+
+void INT_SYS_ClearPending(IRQn_Type irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	if( pIrq != NULL )
+	{
+		__atomic_store_n(&pIrq->isPending, false, __ATOMIC_SEQ_CST);
+	}
+}
+
+void INT_SYS_SetPending(IRQn_Type irqNumber)
+{
+	sim_irq_set_pending(irqNumber);
+}
+
+uint32_t INT_SYS_GetActive(IRQn_Type irqNumber)
+{
+	SIM_IRQ_t * pIrq = sim_irq_find(irqNumber);
+	return ((pIrq != NULL) && __atomic_load_n(&pIrq->isActive, __ATOMIC_SEQ_CST)) ? 1u : 0u;
+}
@@ -0,0 +1,412 @@
+/*
+ * sim_lpuart.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#define _GNU_SOURCE
+#include "Cpu.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "poll.h"
+#include "pthread.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "sys/prctl.h"
+#include "termios.h"
+#include "time.h"
+#include "unistd.h"
+
+/*
+ * LPUART0 on a pseudo terminal.
+ *
+ * The PC tool opens the slave side of the pty (printed at start) like the serial port of the board.
+ * The RX thread takes the bytes at the configured baud rate (10 bits per byte) into the one byte DATA
+ * register: RDRF and the RX interrupt like on the MCU, and OR when the previous byte has not been read
+ * yet, so a too slow RX path loses bytes like on the MCU. The simulation has no CPU time though: the host
+ * may not run the CPU thread for a while, or stretch a short interrupt lock of the bootloader. So while RIE
+ * is set, a byte waits up to SIM_LPUART_IRQ_LATENCY_MAX_NS for the previous one to be read before it overruns.
+ * IDLE is set when no byte follows the last one for the CTRL[IDLECFG] idle characters, with the interrupt if ILIE is set.
+ * The TX side writes to the pty directly.
+ */
+
+#define SIM_LPUART_BITS_PER_BYTE				(10u)
+
+// The longest wait of a received byte for the RX interrupt to read the previous one
+#define SIM_LPUART_IRQ_LATENCY_MAX_NS			(20000000u)
+#define SIM_LPUART_IRQ_POLL_NS					(10000u)
+
+// SDK LPUART driver: the oversampling ratio and baud rate modulo limits
+#define SIM_LPUART_OSR_MIN						(4u)
+#define SIM_LPUART_OSR_MAX						(32u)
+#define SIM_LPUART_SBR_MAX						(8191u)
+
+LPUART_Type sim_LPUART0;
+lpuart_state_t lpuart0_State;
+
+const lpuart_user_config_t lpuart0_InitConfig0 =
+{
+	.baudRate = 115200u
+};
+
+static int sim_lpuart_PtyMaster = -1;
+static int sim_lpuart_PtySlave = -1;
+static volatile uint32_t sim_lpuart_BaudRate = 115200u;
+static uint32_t sim_lpuart_OverrunCount = 0u;
+
+/*
+ * Open the pty, or keep the one inherited over a simulated reset.
+ * @param:
+ * 		ptyMasterFd: the inherited master file descriptor, -1 to open a new pty
+ */
+bool sim_lpuart_init(int ptyMasterFd)
+{
+	struct termios settings;
+	char * pSlaveName = NULL;
+
+	if( ptyMasterFd < 0 )
+	{
+		ptyMasterFd = posix_openpt(O_RDWR | O_NOCTTY);
+		if( (ptyMasterFd < 0) || (grantpt(ptyMasterFd) != 0) || (unlockpt(ptyMasterFd) != 0) )
+		{
+			perror("sim: pty");
+			return false;
+		}
+		pSlaveName = ptsname(ptyMasterFd);
+		if( pSlaveName == NULL )
+		{
+			perror("sim: pty");
+			return false;
+		}
+		// Keep a slave open, otherwise the master reads EIO while the PC tool has not opened the port yet.
+		sim_lpuart_PtySlave = open(pSlaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+		if( (sim_lpuart_PtySlave < 0) || (tcgetattr(sim_lpuart_PtySlave, &settings) != 0) )
+		{
+			perror(pSlaveName);
+			return false;
+		}
+		cfmakeraw(&settings);
+		tcsetattr(sim_lpuart_PtySlave, TCSANOW, &settings);
+		printf("sim: LPUART0 is %s\n", pSlaveName);
+		fflush(stdout);
+	}
+	else
+	{
+		pSlaveName = ptsname(ptyMasterFd);
+		if( pSlaveName != NULL )
+		{
+			sim_lpuart_PtySlave = open(pSlaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+		}
+	}
+	fcntl(ptyMasterFd, F_SETFL, fcntl(ptyMasterFd, F_GETFL) | O_NONBLOCK);
+	sim_lpuart_PtyMaster = ptyMasterFd;
+
+	memset(&sim_LPUART0, 0, sizeof(sim_LPUART0));
+	sim_LPUART0.STAT = LPUART_STAT_TDRE_MASK | LPUART_STAT_TC_MASK;
+	return true;
+}
+
+/*
+ * @return:
+ * 		the pty master file descriptor, inherited by the restarted simulator
+ */
+int sim_lpuart_get_pty(void)
+{
+	return sim_lpuart_PtyMaster;
+}
+
+/*
+ * Reading DATA clears RDRF and the handler clears OR (write 1 to clear), done after the handler returns.
+ */
+static void sim_lpuart_irq_exit(void)
+{
+	if( (sim_LPUART0.CTRL & LPUART_CTRL_RIE_MASK) != 0u )
+	{
+		__atomic_and_fetch(&sim_LPUART0.STAT, ~(LPUART_STAT_RDRF_MASK | LPUART_STAT_OR_MASK), __ATOMIC_SEQ_CST);
+	}
+	if( (sim_LPUART0.CTRL & LPUART_CTRL_ILIE_MASK) != 0u )
+	{
+		__atomic_and_fetch(&sim_LPUART0.STAT, ~LPUART_STAT_IDLE_MASK, __ATOMIC_SEQ_CST);
+	}
+}
+
+static void sim_lpuart_receive(uint8_t rxByte)
+{
+	uint64_t waitStart = 0;
+
+	if( (sim_LPUART0.CTRL & LPUART_CTRL_RE_MASK) == 0u )
+	{
+		return;
+	}
+	waitStart = sim_time_ns();
+	while( ((__atomic_load_n(&sim_LPUART0.STAT, __ATOMIC_SEQ_CST) & LPUART_STAT_RDRF_MASK) != 0u) &&
+		   ((sim_LPUART0.CTRL & LPUART_CTRL_RIE_MASK) != 0u) && ((sim_time_ns() - waitStart) < SIM_LPUART_IRQ_LATENCY_MAX_NS) )
+	{
+		// Let the CPU thread run
+		sim_sleep_ns(SIM_LPUART_IRQ_POLL_NS);
+	}
+	if( (__atomic_load_n(&sim_LPUART0.STAT, __ATOMIC_SEQ_CST) & LPUART_STAT_RDRF_MASK) != 0u )
+	{
+		__atomic_or_fetch(&sim_LPUART0.STAT, LPUART_STAT_OR_MASK, __ATOMIC_SEQ_CST);
+		if( (++sim_lpuart_OverrunCount % 100u) == 1u )
+		{
+			fprintf(stderr, "sim: LPUART0 RX overrun (%u)\n", (unsigned)sim_lpuart_OverrunCount);
+		}
+		return;
+	}
+	sim_LPUART0.DATA = rxByte;
+	__atomic_or_fetch(&sim_LPUART0.STAT, LPUART_STAT_RDRF_MASK, __ATOMIC_SEQ_CST);
+	if( (sim_LPUART0.CTRL & LPUART_CTRL_RIE_MASK) != 0u )
+	{
+		sim_irq_set_pending(LPUART0_RxTx_IRQn);
+	}
+}
+
+/*
+ * The line has been idle for the configured number of characters since the stop bit of the last byte.
+ * @return:
+ * 		the idle time in ns, 0 if the idle line interrupt is not enabled
+ */
+static uint64_t sim_lpuart_idle_time_ns(void)
+{
+	uint32_t idleCharacters = 1u << ((sim_LPUART0.CTRL & LPUART_CTRL_IDLECFG_MASK) >> LPUART_CTRL_IDLECFG_SHIFT);
+
+	if( (sim_LPUART0.CTRL & (LPUART_CTRL_RE_MASK | LPUART_CTRL_ILIE_MASK)) != (LPUART_CTRL_RE_MASK | LPUART_CTRL_ILIE_MASK) )
+	{
+		return 0u;
+	}
+	return (1000000000ull * SIM_LPUART_BITS_PER_BYTE * idleCharacters) / sim_lpuart_BaudRate;
+}
+
+static void sim_lpuart_idle(void)
+{
+	__atomic_or_fetch(&sim_LPUART0.STAT, LPUART_STAT_IDLE_MASK, __ATOMIC_SEQ_CST);
+	sim_irq_set_pending(LPUART0_RxTx_IRQn);
+}
+
+static void * sim_lpuart_rx_thread(void * pArgument)
+{
+	struct pollfd pollFd;
+	struct timespec idleTimeout;
+	uint8_t buffer[256];
+	ssize_t byteNum = 0;
+	ssize_t i = 0;
+	int pollResult = 0;
+	uint64_t byteTime = 0;
+	uint64_t idleTime = 0;
+	uint64_t now = 0;
+	bool isLineActive = false;			// A byte has been received since the line was idle
+
+	(void)pArgument;
+	prctl(PR_SET_TIMERSLACK, 1UL);
+	pollFd.fd = sim_lpuart_PtyMaster;
+	pollFd.events = POLLIN;
+	for(;;)
+	{
+		idleTime = isLineActive ? sim_lpuart_idle_time_ns() : 0u;
+		if( idleTime == 0u )
+		{
+			pollResult = ppoll(&pollFd, 1, NULL, NULL);
+		}
+		else
+		{
+			now = sim_time_ns();
+			idleTime = ((byteTime + idleTime) > now) ? ((byteTime + idleTime) - now) : 0u;
+			idleTimeout.tv_sec = (time_t)(idleTime / 1000000000ull);
+			idleTimeout.tv_nsec = (long)(idleTime % 1000000000ull);
+			pollResult = ppoll(&pollFd, 1, &idleTimeout, NULL);
+		}
+		if( pollResult == 0 )
+		{
+			isLineActive = false;
+			sim_lpuart_idle();
+			continue;
+		}
+		if( pollResult < 0 )
+		{
+			continue;
+		}
+		byteNum = read(sim_lpuart_PtyMaster, buffer, sizeof(buffer));
+		if( byteNum <= 0 )
+		{
+			// No PC tool connected (EIO) or nothing to read yet
+			sim_sleep_ns(1000000u);
+			continue;
+		}
+		byteTime = sim_time_ns();
+		for( i = 0; i < byteNum; i++ )
+		{
+			byteTime += (1000000000ull * SIM_LPUART_BITS_PER_BYTE) / sim_lpuart_BaudRate;
+			sim_sleep_until_ns(byteTime);
+			sim_lpuart_receive(buffer[i]);
+		}
+		isLineActive = true;
+	}
+	return NULL;
+}
+
+void sim_lpuart_start(void)
+{
+	pthread_t thread;
+	sim_irq_set_exit_hook(LPUART0_RxTx_IRQn, sim_lpuart_irq_exit);
+	pthread_create(&thread, NULL, sim_lpuart_rx_thread, NULL);
+}
+
+static void sim_lpuart_write(const uint8_t * txBuff, uint32_t txSize)
+{
+	ssize_t written = 0;
+
+	while( txSize > 0u )
+	{
+		written = write(sim_lpuart_PtyMaster, txBuff, txSize);
+		if( written < 0 )
+		{
+			if( (errno == EAGAIN) || (errno == EINTR) )
+			{
+				sim_sleep_ns(100000u);
+				continue;
+			}
+			return;
+		}
+		txBuff += written;
+		txSize -= (uint32_t)written;
+	}
+}
+
+// Called by the default LPUART0 interrupt handler, which pc_communication.c replaces
+void LPUART0_RxTx_IRQHandler(void)
+{
+	LPUART_DRV_IRQHandler(INST_LPUART0);
+}
+
+/*
+ * S32 SDK LPUART driver
+ */
+status_t LPUART_DRV_Init(uint32_t instance, lpuart_state_t * lpuartStatePtr, const lpuart_user_config_t * lpuartUserConfig)
+{
+	(void)instance;
+	(void)lpuartStatePtr;
+	memset(&lpuart0_State, 0, sizeof(lpuart0_State));
+	(void)LPUART_DRV_SetBaudRate(INST_LPUART0, lpuartUserConfig->baudRate);
+	sim_LPUART0.CTRL |= (LPUART_CTRL_TE_MASK | LPUART_CTRL_RE_MASK);
+	INT_SYS_EnableIRQ(LPUART0_RxTx_IRQn);
+	return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_Deinit(uint32_t instance)
+{
+	(void)instance;
+	sim_LPUART0.CTRL = 0u;
+	INT_SYS_DisableIRQ(LPUART0_RxTx_IRQn);
+	return STATUS_SUCCESS;
+}
+
+uart_callback_t LPUART_DRV_InstallRxCallback(uint32_t instance, uart_callback_t function, void * callbackParam)
+{
+	uart_callback_t previousCallback = lpuart0_State.rxCallback;
+
+	(void)instance;
+	lpuart0_State.rxCallback = function;
+	lpuart0_State.rxCallbackParam = callbackParam;
+	return previousCallback;
+}
+
+void LPUART_DRV_SendDataPolling(uint32_t instance, const uint8_t * txBuff, uint32_t txSize)
+{
+	(void)instance;
+	sim_lpuart_write(txBuff, txSize);
+	// The bytes are shifted out at the baud rate
+	sim_sleep_ns(((uint64_t)txSize * 1000000000ull * SIM_LPUART_BITS_PER_BYTE) / sim_lpuart_BaudRate);
+}
+
+// The transfer is handed to the pty at once, so it is complete when the function returns.
+status_t LPUART_DRV_SendData(uint32_t instance, const uint8_t * txBuff, uint32_t txSize)
+{
+	(void)instance;
+	sim_lpuart_write(txBuff, txSize);
+	lpuart0_State.isTxBusy = false;
+	lpuart0_State.transmitStatus = STATUS_SUCCESS;
+	return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_ReceiveData(uint32_t instance, uint8_t * rxBuff, uint32_t rxSize)
+{
+	(void)instance;
+	lpuart0_State.rxBuff = rxBuff;
+	lpuart0_State.rxSize = rxSize;
+	lpuart0_State.isRxBusy = true;
+	lpuart0_State.receiveStatus = STATUS_BUSY;
+	sim_LPUART0.CTRL |= LPUART_CTRL_RIE_MASK;
+	if( (__atomic_load_n(&sim_LPUART0.STAT, __ATOMIC_SEQ_CST) & LPUART_STAT_RDRF_MASK) != 0u )
+	{
+		sim_irq_set_pending(LPUART0_RxTx_IRQn);
+	}
+	return STATUS_SUCCESS;
+}
+
+status_t LPUART_DRV_AbortReceivingData(uint32_t instance)
+{
+	(void)instance;
+	sim_LPUART0.CTRL &= ~LPUART_CTRL_RIE_MASK;
+	lpuart0_State.isRxBusy = false;
+	lpuart0_State.receiveStatus = STATUS_UART_ABORTED;
+	return STATUS_SUCCESS;
+}
+
+/*
+ * Baud rate = LPUART clock / (OSR * SBR), the OSR with the smallest error like the SDK driver.
+ */
+status_t LPUART_DRV_SetBaudRate(uint32_t instance, uint32_t desiredBaudRate)
+{
+	uint32_t osr = 0;
+	uint32_t sbr = 0;
+	uint32_t calculatedBaud = 0;
+	uint32_t baudDiff = 0;
+	uint32_t bestBaud = 0;
+	uint32_t bestDiff = 0xFFFFFFFFu;
+
+	(void)instance;
+	if( desiredBaudRate == 0u )
+	{
+		return STATUS_ERROR;
+	}
+	for( osr = SIM_LPUART_OSR_MIN; osr <= SIM_LPUART_OSR_MAX; osr++ )
+	{
+		sbr = (SIM_LPUART0_CLOCK + ((desiredBaudRate * osr) / 2u)) / (desiredBaudRate * osr);
+		if( (sbr == 0u) || (sbr > SIM_LPUART_SBR_MAX) )
+		{
+			continue;
+		}
+		calculatedBaud = SIM_LPUART0_CLOCK / (osr * sbr);
+		baudDiff = (calculatedBaud > desiredBaudRate) ? (calculatedBaud - desiredBaudRate) : (desiredBaudRate - calculatedBaud);
+		if( baudDiff <= bestDiff )
+		{
+			bestDiff = baudDiff;
+			bestBaud = calculatedBaud;
+		}
+	}
+	if( bestBaud == 0u )
+	{
+		return STATUS_ERROR;
+	}
+	sim_lpuart_BaudRate = bestBaud;
+	return STATUS_SUCCESS;
+}
+
+void LPUART_DRV_GetBaudRate(uint32_t instance, uint32_t * configuredBaudRate)
+{
+	(void)instance;
+	*configuredBaudRate = sim_lpuart_BaudRate;
+}
+
+void LPUART_DRV_IRQHandler(uint32_t instance)
+{
+	(void)instance;
+	if( ((sim_LPUART0.CTRL & LPUART_CTRL_RIE_MASK) != 0u) &&
+		((__atomic_load_n(&sim_LPUART0.STAT, __ATOMIC_SEQ_CST) & LPUART_STAT_RDRF_MASK) != 0u) &&
+		(lpuart0_State.rxCallback != NULL) )
+	{
+		lpuart0_State.rxCallback(&lpuart0_State, UART_EVENT_RX_FULL, lpuart0_State.rxCallbackParam);
+	}
+}
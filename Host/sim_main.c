@@ -0,0 +1,161 @@
+/*
+ * sim_main.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#define _GNU_SOURCE
+#include "Cpu.h"
+#include "errno.h"
+#include "pthread.h"
+#include "sched.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "sys/prctl.h"
+#include "time.h"
+#include "unistd.h"
+
+/*
+ * Simulator start, reset and the jump out of the bootloader.
+ *
+ * Usage: bootloader_sim [-p pflash.bin] [-e flexnvm.bin] [-t time_scale]
+ * 		-p		the P-Flash file, created erased if it does not exist (default: pflash.bin)
+ * 		-e		the FlexNVM (EEPROM) file, created not partitioned if it does not exist (default: flexnvm.bin)
+ * 		-t		the factor of the flash command execution times, 0 runs them without delay (default: 1)
+ *
+ * A software reset restarts the simulator process with the same files and the same pty (--pty-fd).
+ * The jump to the firmware ends the simulation, the exit status is 0.
+ */
+
+// Sources/main.c, built with main renamed
+extern int bootloader_main(void);
+
+static char * sim_main_pPFlashPath = "pflash.bin";
+static char * sim_main_pFlexNvmPath = "flexnvm.bin";
+static char * sim_main_pTimeScale = "1";
+
+void sim_fatal(const char * pMessage, uint32_t address)
+{
+	fprintf(stderr, "sim: %s: 0x%08X\n", pMessage, (unsigned)address);
+	sim_ftfc_flush();
+	abort();
+}
+
+uint64_t sim_time_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ull) + (uint64_t)now.tv_nsec;
+}
+
+void sim_sleep_until_ns(uint64_t deadline)
+{
+	struct timespec wakeup;
+
+	wakeup.tv_sec = (time_t)(deadline / 1000000000ull);
+	wakeup.tv_nsec = (long)(deadline % 1000000000ull);
+	// The CPU thread is woken up by the interrupt signals
+	while( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL) == EINTR )
+	{
+	}
+}
+
+void sim_sleep_ns(uint64_t ns)
+{
+	sim_sleep_until_ns(sim_time_ns() + ns);
+}
+
+/*
+ * Restart the simulated MCU: the memories are kept in their files, the PC tool keeps the pty.
+ */
+void sim_reset(void)
+{
+	char ptyArgument[32];
+	char * arguments[] = { "bootloader_sim", "-p", sim_main_pPFlashPath, "-e", sim_main_pFlexNvmPath,
+						   "-t", sim_main_pTimeScale, ptyArgument, NULL };
+
+	sim_irq_block_thread();
+	sim_ftfc_flush();
+	printf("sim: reset\n");
+	fflush(stdout);
+	snprintf(ptyArgument, sizeof(ptyArgument), "--pty-fd=%d", sim_lpuart_get_pty());
+	execv("/proc/self/exe", arguments);
+	perror("sim: reset");
+	exit(EXIT_FAILURE);
+}
+
+/*
+ * The jump to a reset handler: the bootloader reset vector restarts, any other ends the simulation.
+ */
+void sim_jump(uint32_t stackPointer, uint32_t programCounter)
+{
+	const uint32_t * pBootloaderVector = (const uint32_t *)sim_memory_address(SIM_PFLASH_BASE);
+
+	if( programCounter == pBootloaderVector[1] )
+	{
+		sim_reset();
+	}
+	sim_irq_block_thread();
+	sim_ftfc_flush();
+	printf("sim: jump to firmware: SP 0x%08X, PC 0x%08X, VTOR 0x%08X\n",
+		   (unsigned)stackPointer, (unsigned)programCounter, (unsigned)S32_SCB->VTOR);
+	fflush(stdout);
+	exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char * argv[])
+{
+	int ptyMasterFd = -1;
+	int option = 0;
+	struct sched_param schedParam;
+
+	// A reset is an exec of the SCHED_IDLE CPU thread, the device threads are created with the normal policy
+	memset(&schedParam, 0, sizeof(schedParam));
+	pthread_setschedparam(pthread_self(), SCHED_OTHER, &schedParam);
+	prctl(PR_SET_TIMERSLACK, 1UL);
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	// The interrupt signals stay blocked (a reset is an exec) until the NVIC model is set up
+	sim_irq_block_thread();
+
+	// --pty-fd=N is given by a simulated reset only
+	if( (argc > 1) && (strncmp(argv[argc - 1], "--pty-fd=", 9) == 0) )
+	{
+		ptyMasterFd = atoi(&argv[argc - 1][9]);
+		argc--;
+	}
+	while( (option = getopt(argc, argv, "p:e:t:")) != -1 )
+	{
+		switch( option )
+		{
+			case 'p':	sim_main_pPFlashPath = optarg;		break;
+			case 'e':	sim_main_pFlexNvmPath = optarg;		break;
+			case 't':	sim_main_pTimeScale = optarg;		break;
+			default:
+				fprintf(stderr, "usage: %s [-p pflash.bin] [-e flexnvm.bin] [-t time_scale]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if( !sim_ftfc_init(sim_main_pPFlashPath, sim_main_pFlexNvmPath, atof(sim_main_pTimeScale)) ||
+		!sim_lpuart_init(ptyMasterFd) )
+	{
+		return EXIT_FAILURE;
+	}
+	// The bootloader clears the sticky flags at every boot, so they show the last reset only
+	RCM->SRS = (ptyMasterFd < 0) ? RCM_SRS_POR_MASK : RCM_SRS_SW_MASK;
+	RCM->SSRS = RCM->SRS;
+	sim_irq_init();
+	sim_ftfc_start();
+	sim_lpuart_start();
+	sim_lpit_start();
+
+	/*
+	 * The device threads must run as soon as they wake up, also while the bootloader is polling,
+	 * otherwise an interrupt or a flash command waits for the next scheduler tick on a single host CPU.
+	 */
+	memset(&schedParam, 0, sizeof(schedParam));
+	pthread_setschedparam(pthread_self(), SCHED_IDLE, &schedParam);
+
+	return bootloader_main();
+}
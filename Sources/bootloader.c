@@ -6,6 +6,11 @@
  */
 
 #include "bootloader.h"
+#include "flash_engine.h"
+#include "delta_patch.h"
+#include "lz4_stream.h"
+#include "crc32.h"
+#include "trace.h"
 #include "pc_communication.h"
 #include "Cpu.h"
 #include "string.h"
@@ -27,7 +32,8 @@
 #define FLASH_SECTOR_SIZE			(4096u) 					// FEATURE_FLS_PF_BLOCK_SECTOR_SIZE
 // The total number of sectors = 128
 #define FLASH_SECTOR_NUM			(128u)
-#define FLASH_WRITE_DATA_SIZE		(64u)
+// The largest data block written by one flash_auto_write_bytes() call (multiple of 8)
+#define FLASH_WRITE_MAX_DATA_SIZE	(248u)
 
 /*
  * The bootloader is stored at the sector 0...11 in the address range (0x0000_0000 ~ 0x0000_BFFF)
@@ -48,12 +54,58 @@
 #define NEW_FIRMWARE_START_SECTOR		(70u)
 #define NEW_FIRMWARE_END_SECTOR			(127u)
 #define NEW_FIRMWARE_MAX_SIZE			(237568u)
+#define NEW_FIRMWARE_SECTOR_NUM			(NEW_FIRMWARE_END_SECTOR - NEW_FIRMWARE_START_SECTOR + 1u)
+
+/*
+ * The firmware to boot (ACTIVE) and the area a download is written into (DOWNLOAD).
+ * With FIRMWARE_AB_SLOTS, slot A is the old firmware area and slot B is the new firmware area.
+ */
+#define FIRMWARE_SLOT_A_START_ADDRESS	(OLD_FIRMWARE_START_ADDRESS)
+#define FIRMWARE_SLOT_B_START_ADDRESS	(NEW_FIRMWARE_START_ADDRESS)
+#ifdef FIRMWARE_AB_SLOTS
+#define ACTIVE_FIRMWARE_START_ADDRESS	((new_firmware_status.activeFirmwareSlot == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_B_START_ADDRESS : FIRMWARE_SLOT_A_START_ADDRESS)
+#define DOWNLOAD_FIRMWARE_START_ADDRESS	((new_firmware_status.activeFirmwareSlot == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_A_START_ADDRESS : FIRMWARE_SLOT_B_START_ADDRESS)
+#else
+#define ACTIVE_FIRMWARE_START_ADDRESS	(OLD_FIRMWARE_START_ADDRESS)
+#define DOWNLOAD_FIRMWARE_START_ADDRESS	(NEW_FIRMWARE_START_ADDRESS)
+#endif
+
+// The reset vector of an application = firmware start address + offset of the reset handler
+#define FIRMWARE_STACK_POINTER			(0x20007000u)
+#define FIRMWARE_RESET_HANDLER_OFFSET	(0x00000411u)
 
 // The new firmware status is stored in EEEPROM
 #define NEW_FIRMWARE_STATUS_START_ADDRESS			(0x14000000u)
 #define NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS 	(NEW_FIRMWARE_STATUS_START_ADDRESS)
 #define NEW_FIRMWARE_STATUS_SIZE_ADDRESS			(NEW_FIRMWARE_STATUS_START_ADDRESS + 4u)
 #define NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS		(NEW_FIRMWARE_STATUS_START_ADDRESS + 8u)
+#define NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS		(NEW_FIRMWARE_STATUS_START_ADDRESS + 12u)
+#define NEW_FIRMWARE_STATUS_INSTALLED_SECTORS_ADDRESS	(NEW_FIRMWARE_STATUS_START_ADDRESS + 24u)
+// The validation record of the active firmware (FIRMWARE_FAST_BOOT)
+#define FIRMWARE_VALIDATED_SIZE_ADDRESS				(NEW_FIRMWARE_STATUS_START_ADDRESS + 28u)
+#define FIRMWARE_VALIDATED_CHECKSUM_ADDRESS			(NEW_FIRMWARE_STATUS_START_ADDRESS + 32u)
+#define FIRMWARE_VERIFY_REQUEST_ADDRESS				(NEW_FIRMWARE_STATUS_START_ADDRESS + 36u)	// Not 0: the next boot verifies the firmware fully
+#define FIRMWARE_VALIDATED_SLOT_ADDRESS				(NEW_FIRMWARE_STATUS_START_ADDRESS + 40u)	// The slot of the validated firmware
+// The resume point of an interrupted download
+#define NEW_FIRMWARE_RESUME_OFFSET_ADDRESS			(NEW_FIRMWARE_STATUS_START_ADDRESS + 16u)
+#define NEW_FIRMWARE_RESUME_IMAGE_ID_ADDRESS		(NEW_FIRMWARE_STATUS_START_ADDRESS + 20u)
+
+#ifdef FIRMWARE_FAST_BOOT
+#define FIRMWARE_BOOT_COUNT_MAGIC					(0x424F4F54u)		// "BOOT"
+
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	count;			// The number of fast boots since the last full verification
+} FIRMWARE_BOOT_COUNT_t;
+
+/*
+ * The boot count is not cleared by the startup code (custom section, outside .bss), so it counts the warm resets
+ * in RAM instead of writing the EEPROM at every boot. The application may use this RAM too, and it is undefined
+ * after a power loss, so an unknown count (power loss or no magic) makes the next boot verify fully.
+ */
+static FIRMWARE_BOOT_COUNT_t firmware_BootCount __attribute__((section (".customSection")));
+#endif
 
 // Text for flash test
 uint8_t test_text[64] = "..allround technology autoliv test..s32k144 firmware update test";
@@ -62,17 +114,33 @@ NEW_FIRMWARE_STATUS_t new_firmware_status =
 		{
 				.isNewFirmwareUpdated = 0u,
 				.newFirmwareSize = 0u,
-				.newFirmwareChecksum = 0u
+				.newFirmwareChecksum = 0u,
+				.activeFirmwareSlot = FIRMWARE_SLOT_A,
+				.installedSectorNum = 0u
 		};
 
-// For 64-bytes data writing and reading
-static uint8_t flash_WriteBuffer[64] = {0};
-static uint8_t flash_ReadBuffer[64] = {0};
+/*
+ * The last data block written, for the verification. The data is programmed from the caller's buffer
+ * (e.g. the payload of the UART rx data packet in the ring buffer) without a copy.
+ */
+static const uint8_t * flash_pLastWriteData = NULL;
+static uint32_t flash_LastWriteStartAddress = 0u;
+static uint32_t flash_LastWriteByteNum = 0u;
+static uint32_t flash_CurrentWriteStartAddress = 0u;
+static uint32_t flash_WrittenBytesCount = 0u;				// The number of bytes written to the new firmware area
+
+/*
+ * One bit per sector of the new firmware area, set once the sector has been erased in the current download.
+ * The sectors are erased on demand when the write cursor first enters them (lazy erase).
+ */
+static uint32_t flash_NewFirmwareErasedSectors[(NEW_FIRMWARE_SECTOR_NUM + 31u) / 32u] = {0};
 
-static uint32_t flash_LastWrite64BytesStartAddress = 0u;
-static uint32_t flash_CurrentWrite64BytesStartAddress = 0u;
-static uint32_t flash_CurrentSectorIndex = 0u; 				// Sector 0...127
-static uint32_t flash_Write64BytesCount = 0u;
+/*
+ * Resumable download: the offset of the last completed sector is recorded in EEPROM for the image
+ * identified by flash_ResumeImageId, so an interrupted download can continue from there.
+ */
+static bool flash_IsResumable = false;
+static uint32_t flash_ResumeImageId = FLASH_RESUME_IMAGE_ID_NONE;
 
 // flash module static
 flash_ssd_config_t flashSSDConfig;
@@ -80,23 +148,44 @@ flash_ssd_config_t flashSSDConfig;
 /*
  * Private Function Prototype
  */
-bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, uint8_t * pBufferToWrite);
+bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, const uint8_t * pBufferToWrite);
 uint8_t flash_readByte(uint32_t readAddress);
-void flash_load_write_buffer(void);
-void flash_write_buffer_little_endian_to_big_endian(void);
-bool flash_check_write_64bytes(void);
+bool flash_check_write(void);
 
-//void flash_auto_write_64bytes_reset(void);
-//bool flash_auto_write_64bytes(void);
+//void flash_auto_write_reset(void);
+//bool flash_auto_write_bytes(const uint8_t * pData, uint32_t byteNum);
 bool flash_overwrite_old_firmware(void);
+bool flash_overwrite_old_firmware_sector(uint32_t sectorOffset, uint32_t sectorByteNum, bool * pIsWritten);
+bool flash_is_area_equal(uint32_t address1, uint32_t address2, uint32_t byteNum);
+bool flash_is_area_blank(uint32_t address, uint32_t byteNum);
+bool flash_program_non_blank_phrases(uint32_t destAddress, uint32_t sourceAddress, uint32_t byteNum);
 
+bool flash_submit_erase_sector(uint8_t sectorIndex, FLASH_ENGINE_CALLBACK_t callback, uint32_t param);
 bool flash_erase_sector(uint8_t sectorIndex);
-bool flash_erase_old_firmware(void);
-bool flash_erase_new_firmware(void);
+void flash_set_new_firmware_sector_erased(bool isSuccessful, uint32_t bitIndex);
+bool flash_erase_new_firmware_on_demand(uint32_t startAddress, uint32_t byteNum);
+
+bool eeprom_write_resume_point(uint32_t resumeOffset, uint32_t imageId);
+bool eeprom_write_install_journal(void);
+#ifdef FIRMWARE_AB_SLOTS
+bool eeprom_write_active_slot(void);
+#endif
+bool eeprom_update_word(uint32_t address, uint32_t value);
+#ifdef FIRMWARE_FAST_BOOT
+bool eeprom_write_validation(uint32_t firmwareSize, uint32_t firmwareChecksum, uint8_t firmwareSlot);
+bool isValidationRecordActive(void);
+bool firmware_verify_active(void);
+bool firmware_fall_back(void);
+#endif
 
 //uint32_t calculateNewFirmwareSize(void);
 //bool calculateNewFirmwareChecksum(uint32_t * pChecksum);
+uint32_t flash_calculate_image_crc32(uint32_t startAddress, uint32_t byteNum);
 bool isOldFirmwareCorrect(void);
+bool isFirmwareEntryValid(uint32_t firmwareStartAddress);
+#ifdef FIRMWARE_AB_SLOTS
+bool firmware_activate_download_slot(void);
+#endif
 
 //bool eeprom_read_new_firmware_status(void);
 //bool eeprom_write_new_firmware_status(void);
@@ -143,6 +232,10 @@ bool flash_init(void)
     		return false;
     	}
     }
+    // Prepare the FTFC command complete interrupt for the flash write engine
+    flash_engine_init();
+    // Prepare the CRC module for the firmware image integrity check
+    crc32_init();
     return true;
 }
 
@@ -219,9 +312,10 @@ void emulated_eeprom_test(void)
 */
 
 // Write Program Flash
-bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, uint8_t * pBufferToWrite)
+bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, const uint8_t * pBufferToWrite)
 {
-	status_t flash_status = STATUS_SUCCESS;
+	FLASH_ENGINE_JOB_t job;
+	bool retValue = false;
 //	uint32_t failAddress = 0;	// Hold the failed write address
 	// Safety Check
 	if( (writeStartAddress % 8u) != 0u )
@@ -253,11 +347,18 @@ bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, uint8_t
 		return false;
 	}
 
-	// Write data to the flash
-	INT_SYS_DisableIRQGlobal();
-	flash_status = FLASH_DRV_Program(&flashSSDConfig, writeStartAddress, writeByteNum, pBufferToWrite);
-    INT_SYS_EnableIRQGlobal();
-	if( flash_status != STATUS_SUCCESS )
+	// Write data to the flash from the caller's buffer by a flash job, the UART RX interrupt is kept alive.
+	job.type = FLASH_ENGINE_JOB_PROGRAM;
+	job.address = writeStartAddress;
+	job.byteNum = writeByteNum;
+	job.pData = pBufferToWrite;
+	job.callback = NULL;
+	job.param = 0u;
+	TRACE_BEGIN(TRACE_EVENT_PROGRAM, writeByteNum);
+	retValue = flash_engine_submit(&job);
+	retValue = flash_engine_wait() && retValue;
+	TRACE_END(TRACE_EVENT_PROGRAM, writeByteNum);
+	if( retValue == false )
 	{
 		return false;
 	}
@@ -277,178 +378,289 @@ bool flash_writeBytes(uint32_t writeStartAddress, uint32_t writeByteNum, uint8_t
 uint8_t flash_readByte(uint32_t readAddress)
 {
 	uint8_t readByte = 0;
-	readByte = *((uint8_t *)readAddress);
+	readByte = *((uint8_t *)MEMORY_ADDRESS(readAddress));
 	return readByte;
 }
 
 /*
- * Load 64-bytes raw data from the UART rx data packet to the flash write buffer.
+ * After a data block has been written to the flash memory,
+ * compare the flash memory with the data that has been written.
  *
- * loading write buffer should be done prior to flash_auto_write_64bytes().
- */
-void flash_load_write_buffer(void)
-{
-	memcpy(flash_WriteBuffer, rx_data_packet.item.raw_data, 64u);
-}
-
-/*
- * The write buffer has 64 bytes or 16 words (32-bits)
- * Every word in the write buffer must be converted from little-endianness to big-endianness.
- * After the little-endianness to big-endianness conversion,
- * then you can write the contents in the write buffer to flash.
- *
- */
-void flash_write_buffer_little_endian_to_big_endian(void)
-{
-	uint32_t * write_buffer_word = (uint32_t *)flash_WriteBuffer;
-	uint8_t i = 0;
-	for(i = 0; i < 16; i++)
-	{
-		write_buffer_word[i] = LE2BE_32(write_buffer_word[i]);
-	}
-}
-
-/*
- * After 64-bytes data have been written to the flash memory from the flash write buffer,
- * read the 64 bytes into the flash read buffer,
- * then compare the flash read buffer and the flash write buffer.
+ * FLASH_VERIFY_BY_COMMAND: one Program Check command sequence over the whole data block, at the user margin level.
+ * Otherwise word by word by the CPU. The flash write engine is idle when the data block has been written,
+ * no flash command runs while the P-Flash is read (no read collision), so the interrupts are not masked.
  *
  * @return:
- * 		true: 	success in writing 64 bytes
- * 		false:  error in writing 64 bytes
+ * 		true: 	success in writing the data block
+ * 		false:  error in writing the data block
  */
-bool flash_check_write_64bytes(void)
+bool flash_check_write(void)
 {
-	int retValue = 0;
-	uint8_t i = 0;
-	uint8_t * checkStartAddress = (uint8_t *)flash_LastWrite64BytesStartAddress;
+#ifdef FLASH_VERIFY_BY_COMMAND
+	status_t flash_status = STATUS_SUCCESS;
+	uint32_t failAddress = 0;
 
-	INT_SYS_DisableIRQGlobal();
-	//Note: The memory copy sometimes failed, so suggest not to use it anymore.
-	//memcpy(flash_ReadBuffer, (uint8_t *)flash_LastWrite64BytesStartAddress, 64u);
-	for( i = 0; i < 64u; i++ )
-	{
-		// Read 64 bytes from flash.
-		flash_ReadBuffer[i] = checkStartAddress[i];
-	}
-	//retValue = memcmp(flash_ReadBuffer, flash_WriteBuffer, 64u);
-	for( i = 0; i < 64u; i++ )
-	{
-		if( flash_ReadBuffer[i] != flash_WriteBuffer[i] )
-		{
-			retValue++;
-		}
-	}
-	INT_SYS_EnableIRQGlobal();
+	TRACE_BEGIN(TRACE_EVENT_VERIFY, flash_LastWriteByteNum);
+	// Critical section where only the RAM-resident interrupts are served.
+	flash_engine_mask_irq();
+	flash_status = FLASH_DRV_ProgramCheck(&flashSSDConfig, flash_LastWriteStartAddress, flash_LastWriteByteNum, flash_pLastWriteData,
+										  &failAddress, FLASH_VERIFY_MARGIN_LEVEL);
+	flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_VERIFY, flash_LastWriteByteNum);
+
+	return (flash_status == STATUS_SUCCESS);
+#else
+	const uint32_t * pFlashWord = (const uint32_t *)MEMORY_ADDRESS(flash_LastWriteStartAddress);
+	uint32_t dataWord[2];
+	uint32_t wordNum = flash_LastWriteByteNum / 4u;
+	uint32_t difference = 0u;
+	uint32_t i = 0;
 
-	if( retValue == 0 )
+	TRACE_BEGIN(TRACE_EVENT_VERIFY, flash_LastWriteByteNum);
+	// One phrase (two words) per iteration, the byte number is a multiple of 8. The data may be unaligned.
+	for( i = 0; i < wordNum; i += 2u )
 	{
-		// The data in both flash_ReadBuffer and flash_WriteBuffer are equal.
-		return true;
-	}
-	else
-	{
-		return false;
+		memcpy(dataWord, &flash_pLastWriteData[i * 4u], sizeof(dataWord));
+		difference |= (pFlashWord[i] ^ dataWord[0]) | (pFlashWord[i + 1u] ^ dataWord[1]);
 	}
+	TRACE_END(TRACE_EVENT_VERIFY, flash_LastWriteByteNum);
+
+	// The data in both the flash memory and the written data are equal.
+	return (difference == 0u);
+#endif
 }
 
 /*
- * If you want flash_auto_write_64bytes() function to rewrite data from the New Firmware Start Address again,
+ * If you want flash_auto_write_bytes() function to rewrite data from the New Firmware Start Address again,
  * call this function.
  *
  */
-void flash_auto_write_64bytes_reset(void)
+void flash_auto_write_reset(void)
 {
-	flash_Write64BytesCount = 0;
+	flash_WrittenBytesCount = 0;
+	// The next download is only resumable after flash_auto_write_resume().
+	flash_IsResumable = false;
+	flash_ResumeImageId = FLASH_RESUME_IMAGE_ID_NONE;
+	// A delta patch rebuilds the new firmware from the installed (old) firmware.
+	delta_patch_reset((const uint8_t *)MEMORY_ADDRESS(ACTIVE_FIRMWARE_START_ADDRESS), OLD_FIRMWARE_MAX_SIZE, flash_auto_write_bytes);
+	// A compressed image refers back to the part of the new firmware that is already written.
+	lz4_stream_reset((const uint8_t *)MEMORY_ADDRESS(DOWNLOAD_FIRMWARE_START_ADDRESS), NEW_FIRMWARE_MAX_SIZE, flash_auto_write_bytes);
 }
 
 /*
- * It continuously fills 64-bytes data into flash memory in new firmware area
+ * It continuously fills a data block into flash memory in new firmware area
  * every time when you call it.
+ * @param:
+ * 		pData: the data block to write, programmed without a copy (any alignment)
+ * 		byteNum: the size of the data block, multiple of 8 and at most FLASH_WRITE_MAX_DATA_SIZE
  */
-bool flash_auto_write_64bytes(void)
+bool flash_auto_write_bytes(const uint8_t * pData, uint32_t byteNum)
 {
 	bool retValue = false;
 
-	if(flash_Write64BytesCount == 0)
+	if(pData == NULL)
 	{
-		// Now start the writing of the first 64 bytes.
-		flash_CurrentWrite64BytesStartAddress = NEW_FIRMWARE_START_ADDRESS;
-		retValue = flash_erase_new_firmware();
-		if(retValue == false)
+		return false;
+	}
+
+	if( (byteNum == 0u) || (byteNum > FLASH_WRITE_MAX_DATA_SIZE) ||
+		((byteNum % FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) != 0u) )
+	{
+		return false;
+	}
+
+	if( (flash_WrittenBytesCount + byteNum) > NEW_FIRMWARE_MAX_SIZE )
+	{
+		// The new firmware does not fit into the new firmware area.
+		return false;
+	}
+
+	if(flash_WrittenBytesCount == 0)
+	{
+		// Now start the writing of the first data block. No sector of the new firmware area is erased yet.
+		memset(flash_NewFirmwareErasedSectors, 0, sizeof(flash_NewFirmwareErasedSectors));
+		if( (flash_IsResumable == false) && (eeprom_write_resume_point(0u, FLASH_RESUME_IMAGE_ID_NONE) == false) )
 		{
-			// Flash erasing failure
+			// The resume point of another image must not survive this download.
 			return false;
 		}
 	}
-	else
+#ifdef FLASH_USE_PROGRAM_SECTION
+	// Use FlexRAM as the section program buffer during the download (again after a resume point update).
+	flash_engine_set_section_buffer(true);
+#endif
+	// The data blocks are written back to back from the new firmware start address.
+	flash_CurrentWriteStartAddress = DOWNLOAD_FIRMWARE_START_ADDRESS + flash_WrittenBytesCount;
+	// Erase the sectors that the data block enters for the first time.
+	retValue = flash_erase_new_firmware_on_demand(flash_CurrentWriteStartAddress, byteNum);
+	if(retValue == false)
 	{
-		// Some 64-bytes data blocks have been written to the flash memory
-		flash_CurrentWrite64BytesStartAddress = flash_LastWrite64BytesStartAddress + FLASH_WRITE_DATA_SIZE;
+		// Flash erasing failure
+		return false;
 	}
-	// Decide which sector the current start address is in.
-	flash_CurrentSectorIndex = flash_CurrentWrite64BytesStartAddress / FLASH_SECTOR_SIZE;
-	// Load the flash write buffer from the rx data packet prior to flash writing
-	flash_load_write_buffer();
-//	flash_write_buffer_little_endian_to_big_endian();
-
-	// Write the data block to the flash
-	retValue = flash_writeBytes(flash_CurrentWrite64BytesStartAddress, FLASH_WRITE_DATA_SIZE, flash_WriteBuffer);
+	// Write the data block to the flash directly from pData
+	retValue = flash_writeBytes(flash_CurrentWriteStartAddress, byteNum, pData);
 	if(retValue == false)
 	{
 		// Flash writing failure
 		return false;
 	}
-	flash_LastWrite64BytesStartAddress = flash_CurrentWrite64BytesStartAddress;
+	flash_pLastWriteData = pData;
+	flash_LastWriteStartAddress = flash_CurrentWriteStartAddress;
+	flash_LastWriteByteNum = byteNum;
 
 	// Check if the flash write is successful
-	retValue = flash_check_write_64bytes();
+	retValue = flash_check_write();
 	if(retValue == false)
 	{
 		// Mismatch in flash writing data
 		return false;
 	}
 
-	flash_Write64BytesCount++;
+	flash_WrittenBytesCount += byteNum;
+
+	if( flash_IsResumable &&
+		((flash_WrittenBytesCount / FLASH_SECTOR_SIZE) != ((flash_WrittenBytesCount - byteNum) / FLASH_SECTOR_SIZE)) )
+	{
+		// A sector is complete and verified, record the start of the current sector as the resume point.
+		if( eeprom_write_resume_point(flash_WrittenBytesCount - (flash_WrittenBytesCount % FLASH_SECTOR_SIZE), flash_ResumeImageId) == false )
+		{
+			// The older resume point is still valid, just stop updating it.
+			flash_IsResumable = false;
+		}
+	}
 	// Flash writing success
 	return true;
 }
 
+/*
+ * Continue an interrupted download of the same image from its resume point.
+ * A different image starts from zero and becomes the image whose resume point is recorded.
+ * The sectors below the resume point are kept, the sector at the resume point is erased again
+ * when the write cursor enters it.
+ * @param:
+ * 		imageId: identifies the image to download (the host uses the CRC-32 of the image)
+ * @return:
+ * 		the offset in the new firmware area where the host continues, multiple of FLASH_SECTOR_SIZE
+ */
+uint32_t flash_auto_write_resume(uint32_t imageId)
+{
+	uint32_t resumeOffset = 0;
+	uint32_t bitIndex = 0;
+
+	flash_auto_write_reset();
+#ifdef FLASH_USE_PROGRAM_SECTION
+	// FlexRAM may still be the section program buffer.
+	if( flash_engine_set_section_buffer(false) == false )
+	{
+		return 0u;
+	}
+#endif
+	if( flashSSDConfig.EEESize == 0u )
+	{
+		// No Emulated EEPROM is assigned, nothing can be resumed
+		return 0u;
+	}
+
+	resumeOffset = *((uint32_t *)MEMORY_ADDRESS(NEW_FIRMWARE_RESUME_OFFSET_ADDRESS));
+	if( (imageId == FLASH_RESUME_IMAGE_ID_NONE) ||
+		(*((uint32_t *)MEMORY_ADDRESS(NEW_FIRMWARE_RESUME_IMAGE_ID_ADDRESS)) != imageId) ||
+		(resumeOffset >= NEW_FIRMWARE_MAX_SIZE) || ((resumeOffset % FLASH_SECTOR_SIZE) != 0u) )
+	{
+		// Start the image from zero
+		resumeOffset = 0u;
+		if( eeprom_write_resume_point(0u, imageId) == false )
+		{
+			return 0u;
+		}
+	}
+
+	memset(flash_NewFirmwareErasedSectors, 0, sizeof(flash_NewFirmwareErasedSectors));
+	for(bitIndex = 0; bitIndex < (resumeOffset / FLASH_SECTOR_SIZE); bitIndex++)
+	{
+		// Erased and completely written in the interrupted download
+		flash_NewFirmwareErasedSectors[bitIndex / 32u] |= (1uL << (bitIndex % 32u));
+	}
+	flash_WrittenBytesCount = resumeOffset;
+	flash_ResumeImageId = imageId;
+	flash_IsResumable = true;
+	return resumeOffset;
+}
+
+/*
+ * Forget the resume point, once the download is complete or has been given up.
+ */
+bool flash_auto_write_resume_clear(void)
+{
+	flash_IsResumable = false;
+	flash_ResumeImageId = FLASH_RESUME_IMAGE_ID_NONE;
+	return eeprom_write_resume_point(0u, FLASH_RESUME_IMAGE_ID_NONE);
+}
+
 /*
  * Copy the new firmware and overwrite the old firmware
+ *
+ * The copy is differential: every 4kB sector of the old firmware area is compared with
+ * the new firmware first, and only the sectors that differ are erased and programmed.
  */
 bool flash_overwrite_old_firmware(void)
 {
 	bool retValue = false;
 	uint32_t firmwareSize = 0;
-	status_t flash_status = STATUS_SUCCESS;
-	uint32_t failAddress = 0;
-	// Erase the old firmware area
-	retValue = flash_erase_old_firmware();
-	if(retValue == false)
-	{
-		// Fail to erase old flash firmware.
-		return false;
-	}
+	uint32_t sectorOffset = 0;
+	uint32_t sectorByteNum = 0;
+	bool isSectorWritten = false;
 	// Get new firmware size in bytes
 	firmwareSize = new_firmware_status.newFirmwareSize;
-	// Start to copy new firmware to old firmware area
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
-	flash_status = FLASH_DRV_Program(&flashSSDConfig, OLD_FIRMWARE_START_ADDRESS, firmwareSize, (uint8_t *)NEW_FIRMWARE_START_ADDRESS);
-	INT_SYS_EnableIRQGlobal();
-	if( flash_status != STATUS_SUCCESS )
+	if( firmwareSize > OLD_FIRMWARE_MAX_SIZE )
 	{
 		return false;
 	}
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
-	flash_status = FLASH_DRV_ProgramCheck(&flashSSDConfig, OLD_FIRMWARE_START_ADDRESS, firmwareSize, (uint8_t *)NEW_FIRMWARE_START_ADDRESS, &failAddress, 0x01);
-	INT_SYS_EnableIRQGlobal();
-	if( flash_status != STATUS_SUCCESS )
+	// Never install a disturbed new firmware. The old firmware is still intact if no sector is overwritten yet.
+	if( flash_calculate_image_crc32(NEW_FIRMWARE_START_ADDRESS, firmwareSize) != new_firmware_status.newFirmwareChecksum )
 	{
 		return false;
 	}
+	/*
+	 * Start to copy new firmware to old firmware area sector by sector.
+	 * After a power failure the copy continues at the first sector not recorded in the install journal.
+	 */
+	for(sectorOffset = new_firmware_status.installedSectorNum * FLASH_SECTOR_SIZE; sectorOffset < OLD_FIRMWARE_MAX_SIZE; sectorOffset += FLASH_SECTOR_SIZE)
+	{
+		// The number of new firmware bytes in this sector. The rest of the sector must be blank.
+		if( sectorOffset >= firmwareSize )
+		{
+			sectorByteNum = 0u;
+		}
+		else if( (firmwareSize - sectorOffset) >= FLASH_SECTOR_SIZE )
+		{
+			sectorByteNum = FLASH_SECTOR_SIZE;
+		}
+		else
+		{
+			sectorByteNum = firmwareSize - sectorOffset;
+		}
+		TRACE_BEGIN(TRACE_EVENT_INSTALL_SECTOR, (OLD_FIRMWARE_START_ADDRESS + sectorOffset) / FLASH_SECTOR_SIZE);
+		retValue = flash_overwrite_old_firmware_sector(sectorOffset, sectorByteNum, &isSectorWritten);
+		TRACE_END(TRACE_EVENT_INSTALL_SECTOR, (OLD_FIRMWARE_START_ADDRESS + sectorOffset) / FLASH_SECTOR_SIZE);
+		if(retValue == false)
+		{
+			// Fail to overwrite the old firmware sector.
+			return false;
+		}
+		new_firmware_status.installedSectorNum++;
+		if(!isSectorWritten)
+		{
+			// An unchanged sector is only checked again after a power failure, it needs no journal write.
+			continue;
+		}
+		// Journal the sector (and the unchanged sectors before it), it is never copied again in this install.
+		retValue = eeprom_write_install_journal();
+		if(retValue == false)
+		{
+			return false;
+		}
+	}
 	if(!isOldFirmwareCorrect())
 	{
 		return false;
@@ -457,38 +669,77 @@ bool flash_overwrite_old_firmware(void)
 }
 
 /*
- * Erase the specified flash sector
+ * Overwrite one old firmware sector with the new firmware.
+ * The sector is neither erased nor programmed if it already holds the new firmware,
+ * and the phrases which are all 0xFF are not programmed after the erase.
  * @param:
- * 		sectorIndex: 0 ~ 127 corresponding to each 4kB sector
+ * 		sectorOffset: the offset of the sector from the firmware start address
+ * 		sectorByteNum: the number of new firmware bytes in this sector (0...FLASH_SECTOR_SIZE)
+ * 		pIsWritten: set to true if the sector has been erased and programmed, false if it was unchanged
  */
-bool flash_erase_sector(uint8_t sectorIndex)
+bool flash_overwrite_old_firmware_sector(uint32_t sectorOffset, uint32_t sectorByteNum, bool * pIsWritten)
 {
-	uint32_t flash_ErasedSectorStartAddress = 0;
-	status_t flash_status = STATUS_SUCCESS;
-	if(sectorIndex > 127u)
+	bool retValue = false;
+	uint32_t oldSectorAddress = OLD_FIRMWARE_START_ADDRESS + sectorOffset;
+	uint32_t newSectorAddress = NEW_FIRMWARE_START_ADDRESS + sectorOffset;
+
+	*pIsWritten = false;
+	if( flash_is_area_equal(oldSectorAddress, newSectorAddress, sectorByteNum) &&
+		flash_is_area_blank(oldSectorAddress + sectorByteNum, FLASH_SECTOR_SIZE - sectorByteNum) )
+	{
+		// The sector is unchanged. Skip erasing and programming.
+		return true;
+	}
+
+	*pIsWritten = true;
+	retValue = flash_erase_sector((uint8_t)(oldSectorAddress / FLASH_SECTOR_SIZE));
+	if(retValue == false)
 	{
 		return false;
 	}
-	flash_ErasedSectorStartAddress = sectorIndex * FLASH_SECTOR_SIZE;
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
-	flash_status = FLASH_DRV_EraseSector(&flashSSDConfig, flash_ErasedSectorStartAddress, FLASH_SECTOR_SIZE);
-	INT_SYS_EnableIRQGlobal();
-	if( flash_status != STATUS_SUCCESS )
+	retValue = flash_program_non_blank_phrases(oldSectorAddress, newSectorAddress, sectorByteNum);
+	if(retValue == false)
 	{
 		return false;
 	}
+	// Check if the sector is successfully overwritten
+	return flash_is_area_equal(oldSectorAddress, newSectorAddress, sectorByteNum);
+}
+
+/*
+ * Compare two flash areas word by word.
+ * @param:
+ * 		address1, address2: word aligned flash addresses
+ * 		byteNum: multiple of 4
+ */
+bool flash_is_area_equal(uint32_t address1, uint32_t address2, uint32_t byteNum)
+{
+	const uint32_t * pWord1 = (const uint32_t *)MEMORY_ADDRESS(address1);
+	const uint32_t * pWord2 = (const uint32_t *)MEMORY_ADDRESS(address2);
+	uint32_t i = 0;
+	for( i = 0; i < (byteNum / 4u); i++ )
+	{
+		if( pWord1[i] != pWord2[i] )
+		{
+			return false;
+		}
+	}
 	return true;
 }
 
-bool flash_erase_old_firmware(void)
+/*
+ * Check if a flash area is erased (all 0xFF).
+ * @param:
+ * 		address: word aligned flash address
+ * 		byteNum: multiple of 4
+ */
+bool flash_is_area_blank(uint32_t address, uint32_t byteNum)
 {
-	uint8_t sectorIndex = 0;
-	bool retValue = false;
-	for(sectorIndex = OLD_FIRMWARE_START_SECTOR; sectorIndex <= OLD_FIRMWARE_END_SECTOR; sectorIndex++)
+	const uint32_t * pWord = (const uint32_t *)MEMORY_ADDRESS(address);
+	uint32_t i = 0;
+	for( i = 0; i < (byteNum / 4u); i++ )
 	{
-		retValue = flash_erase_sector(sectorIndex);
-		if(retValue == false)
+		if( pWord[i] != 0xFFFFFFFFu )
 		{
 			return false;
 		}
@@ -496,14 +747,50 @@ bool flash_erase_old_firmware(void)
 	return true;
 }
 
-bool flash_erase_new_firmware(void)
+/*
+ * Program the source flash area to the erased destination, skipping the phrases which are all 0xFF.
+ * The consecutive non-blank phrases are programmed by one FLASH_DRV_Program() call.
+ * @param:
+ * 		destAddress, sourceAddress: 8-bytes aligned flash addresses
+ * 		byteNum: multiple of 8
+ */
+bool flash_program_non_blank_phrases(uint32_t destAddress, uint32_t sourceAddress, uint32_t byteNum)
 {
-	uint8_t sectorIndex = 0;
-	bool retValue = false;
-	for(sectorIndex = NEW_FIRMWARE_START_SECTOR; sectorIndex <= NEW_FIRMWARE_END_SECTOR; sectorIndex++)
+	status_t flash_status = STATUS_SUCCESS;
+	uint32_t failAddress = 0;
+	uint32_t offset = 0;
+	uint32_t runStart = 0;
+
+	while( offset < byteNum )
 	{
-		retValue = flash_erase_sector(sectorIndex);
-		if(retValue == false)
+		// Skip the blank phrases
+		while( (offset < byteNum) && flash_is_area_blank(sourceAddress + offset, FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) )
+		{
+			offset += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+		}
+		// Collect the following non-blank phrases
+		runStart = offset;
+		while( (offset < byteNum) && !flash_is_area_blank(sourceAddress + offset, FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE) )
+		{
+			offset += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+		}
+		if( offset == runStart )
+		{
+			break;
+		}
+		// Critical section where only the RAM-resident interrupts are served.
+		flash_engine_mask_irq();
+		flash_status = FLASH_DRV_Program(&flashSSDConfig, destAddress + runStart, offset - runStart, (uint8_t *)MEMORY_ADDRESS(sourceAddress + runStart));
+		flash_engine_unmask_irq();
+		if( flash_status != STATUS_SUCCESS )
+		{
+			return false;
+		}
+		// Critical section where only the RAM-resident interrupts are served.
+		flash_engine_mask_irq();
+		flash_status = FLASH_DRV_ProgramCheck(&flashSSDConfig, destAddress + runStart, offset - runStart, (uint8_t *)MEMORY_ADDRESS(sourceAddress + runStart), &failAddress, 0x01);
+		flash_engine_unmask_irq();
+		if( flash_status != STATUS_SUCCESS )
 		{
 			return false;
 		}
@@ -511,16 +798,130 @@ bool flash_erase_new_firmware(void)
 	return true;
 }
 
+/*
+ * Queue the erase of the specified flash sector, followed by its blank check with FLASH_VERIFY_BY_COMMAND.
+ * @param:
+ * 		sectorIndex: 0 ~ 127 corresponding to each 4kB sector
+ * 		callback: called when the sector is erased (and blank checked), or NULL
+ * 		param: passed to the callback
+ */
+bool flash_submit_erase_sector(uint8_t sectorIndex, FLASH_ENGINE_CALLBACK_t callback, uint32_t param)
+{
+	FLASH_ENGINE_JOB_t job;
+
+	if(sectorIndex > 127u)
+	{
+		return false;
+	}
+	job.type = FLASH_ENGINE_JOB_ERASE_SECTOR;
+	job.address = sectorIndex * FLASH_SECTOR_SIZE;
+	job.byteNum = FLASH_SECTOR_SIZE;
+	job.pData = NULL;
+	job.callback = callback;
+	job.param = param;
+#ifdef FLASH_VERIFY_BY_COMMAND
+	// The callback belongs to the blank check of the whole sector (Read 1s Section)
+	job.callback = NULL;
+	if( flash_engine_submit(&job) == false )
+	{
+		return false;
+	}
+	job.type = FLASH_ENGINE_JOB_VERIFY_BLANK;
+	job.callback = callback;
+#endif
+	return flash_engine_submit(&job);
+}
+
+/*
+ * Erase the specified flash sector
+ * @param:
+ * 		sectorIndex: 0 ~ 127 corresponding to each 4kB sector
+ */
+bool flash_erase_sector(uint8_t sectorIndex)
+{
+	bool retValue = false;
+
+	TRACE_BEGIN(TRACE_EVENT_ERASE_SECTOR, sectorIndex);
+	retValue = flash_submit_erase_sector(sectorIndex, NULL, 0u);
+	// Wait anyway: a part of the jobs may be queued.
+	retValue = flash_engine_wait() && retValue;
+	TRACE_END(TRACE_EVENT_ERASE_SECTOR, sectorIndex);
+	return retValue;
+}
+
+/*
+ * Flash job callback: the sector of the new firmware area with the bit index param is erased.
+ */
+void flash_set_new_firmware_sector_erased(bool isSuccessful, uint32_t bitIndex)
+{
+	if( isSuccessful )
+	{
+		flash_NewFirmwareErasedSectors[bitIndex / 32u] |= (1uL << (bitIndex % 32u));
+	}
+}
+
+/*
+ * Erase the sectors of the new firmware area covered by the address range, if they have not
+ * been erased yet in the current download.
+ * The sectors are erased back to back by one batch of flash jobs, and the UART RX interrupt keeps
+ * receiving the next data packets meanwhile, so the PC does not wait for the whole new firmware area to be erased.
+ * @param:
+ * 		startAddress: the start address of the data block in the new firmware area
+ * 		byteNum: the size of the data block
+ */
+bool flash_erase_new_firmware_on_demand(uint32_t startAddress, uint32_t byteNum)
+{
+	uint32_t sectorIndex = 0;
+	uint32_t bitIndex = 0;
+	uint32_t endSectorIndex = 0;
+	uint32_t erasedSectorNum = 0;
+	bool retValue = true;
+
+	if( (byteNum == 0u) || (startAddress < DOWNLOAD_FIRMWARE_START_ADDRESS) ||
+		((startAddress + byteNum) > (DOWNLOAD_FIRMWARE_START_ADDRESS + NEW_FIRMWARE_MAX_SIZE)) )
+	{
+		return false;
+	}
+
+	endSectorIndex = (startAddress + byteNum - 1u) / FLASH_SECTOR_SIZE;
+	for(sectorIndex = startAddress / FLASH_SECTOR_SIZE; (sectorIndex <= endSectorIndex) && retValue; sectorIndex++)
+	{
+		bitIndex = sectorIndex - (DOWNLOAD_FIRMWARE_START_ADDRESS / FLASH_SECTOR_SIZE);
+		if( (flash_NewFirmwareErasedSectors[bitIndex / 32u] & (1uL << (bitIndex % 32u))) != 0u )
+		{
+			// Already erased in this download
+			continue;
+		}
+		if( erasedSectorNum == 0u )
+		{
+			TRACE_BEGIN(TRACE_EVENT_ERASE_SECTOR, sectorIndex);
+		}
+		erasedSectorNum++;
+		// The sector is marked as erased by the job callback.
+		retValue = flash_submit_erase_sector((uint8_t)sectorIndex, flash_set_new_firmware_sector_erased, bitIndex);
+	}
+	if( erasedSectorNum == 0u )
+	{
+		return true;
+	}
+	retValue = flash_engine_wait() && retValue;
+	TRACE_END(TRACE_EVENT_ERASE_SECTOR, erasedSectorNum);
+	return retValue;
+}
+
 /*
  * Get the size of the firmware that you have written to flash
  */
 uint32_t calculateNewFirmwareSize(void)
 {
 	uint32_t size = 0;
-	size = flash_Write64BytesCount * FLASH_WRITE_DATA_SIZE;
+	size = flash_WrittenBytesCount;
 	return size;
 }
 
+/*
+ * Calculate the CRC-32 of the firmware that you have written to flash
+ */
 bool calculateNewFirmwareChecksum(uint32_t * pChecksum)
 {
 	if(pChecksum == NULL)
@@ -528,30 +929,40 @@ bool calculateNewFirmwareChecksum(uint32_t * pChecksum)
 		return false;
 	}
 	uint32_t newFirmwareSize = 0;
-	status_t flash_status = STATUS_SUCCESS;
-	newFirmwareSize = flash_Write64BytesCount * FLASH_WRITE_DATA_SIZE;
-	flash_status = FLASH_DRV_CheckSum(&flashSSDConfig, NEW_FIRMWARE_START_ADDRESS, newFirmwareSize, pChecksum);
-	if( flash_status != STATUS_SUCCESS )
+	newFirmwareSize = flash_WrittenBytesCount;
+	if( newFirmwareSize > NEW_FIRMWARE_MAX_SIZE )
 	{
 		return false;
 	}
+	*pChecksum = flash_calculate_image_crc32(DOWNLOAD_FIRMWARE_START_ADDRESS, newFirmwareSize);
 	return true;
 }
 
 /*
- * Compare the old firmware checksum with the new firmware checksum
+ * Calculate the CRC-32 of a firmware image in flash
+ */
+uint32_t flash_calculate_image_crc32(uint32_t startAddress, uint32_t byteNum)
+{
+	uint32_t checksum = 0;
+	TRACE_BEGIN(TRACE_EVENT_VERIFY_IMAGE, byteNum / 1024u);
+	checksum = crc32_calculate((const uint8_t *)MEMORY_ADDRESS(startAddress), byteNum);
+	TRACE_END(TRACE_EVENT_VERIFY_IMAGE, byteNum / 1024u);
+	return checksum;
+}
+
+/*
+ * Compare the old firmware CRC-32 with the new firmware CRC-32
  */
 bool isOldFirmwareCorrect(void)
 {
 	uint32_t oldFirmwareSize = 0;
 	uint32_t oldFirmwareChecksum = 0;
-	status_t flash_status = STATUS_SUCCESS;
 	oldFirmwareSize = new_firmware_status.newFirmwareSize;
-	flash_status = FLASH_DRV_CheckSum(&flashSSDConfig, OLD_FIRMWARE_START_ADDRESS, oldFirmwareSize, &oldFirmwareChecksum);
-	if( flash_status != STATUS_SUCCESS )
+	if( oldFirmwareSize > OLD_FIRMWARE_MAX_SIZE )
 	{
 		return false;
 	}
+	oldFirmwareChecksum = flash_calculate_image_crc32(OLD_FIRMWARE_START_ADDRESS, oldFirmwareSize);
 	if( oldFirmwareChecksum != new_firmware_status.newFirmwareChecksum )
 	{
 		return false;
@@ -564,15 +975,32 @@ bool isOldFirmwareCorrect(void)
  */
 bool eeprom_read_new_firmware_status(void)
 {
+#ifdef FLASH_USE_PROGRAM_SECTION
+	// FlexRAM may still be the section program buffer after a download.
+	if( flash_engine_set_section_buffer(false) == false )
+	{
+		return false;
+	}
+#endif
     /* Try to read data from EEPROM if FlexRAM is configured as Emulated EEPROM */
     if (flashSSDConfig.EEESize == 0u)
     {
     	// No Emulated EEPROM is assigned
     	return false;
     }
-    new_firmware_status.isNewFirmwareUpdated = 	*((uint8_t  *)NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS);
-    new_firmware_status.newFirmwareSize = 		*((uint32_t *)NEW_FIRMWARE_STATUS_SIZE_ADDRESS);
-    new_firmware_status.newFirmwareChecksum = 	*((uint32_t *)NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS);
+    new_firmware_status.isNewFirmwareUpdated = 	*((uint8_t  *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS));
+    new_firmware_status.newFirmwareSize = 		*((uint32_t *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_SIZE_ADDRESS));
+    new_firmware_status.newFirmwareChecksum = 	*((uint32_t *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS));
+#ifdef FIRMWARE_AB_SLOTS
+    // The erased EEPROM (0xFF) selects slot A.
+    new_firmware_status.activeFirmwareSlot =	(*((uint8_t  *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS)) == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_B : FIRMWARE_SLOT_A;
+#endif
+    new_firmware_status.installedSectorNum =	*((uint32_t *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_INSTALLED_SECTORS_ADDRESS));
+    if( new_firmware_status.installedSectorNum > (OLD_FIRMWARE_MAX_SIZE / FLASH_SECTOR_SIZE) )
+    {
+    	// The erased EEPROM (0xFFFFFFFF): no sector is installed yet.
+    	new_firmware_status.installedSectorNum = 0u;
+    }
     return true;
 }
 
@@ -583,38 +1011,193 @@ bool eeprom_write_new_firmware_status(void)
 {
 	status_t eeprom_status = STATUS_SUCCESS;
 
+#ifdef FLASH_USE_PROGRAM_SECTION
+	// FlexRAM may still be the section program buffer after a download.
+	if( flash_engine_set_section_buffer(false) == false )
+	{
+		return false;
+	}
+#endif
+
 	// Write new firmware update flag
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
     eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS, sizeof(uint8_t), (uint8_t *)&new_firmware_status.isNewFirmwareUpdated);
-    INT_SYS_EnableIRQGlobal();
+    flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
     if( eeprom_status != STATUS_SUCCESS )
 	{
 		return false;
 	}
 
 	// Write new firmware size
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_SIZE_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
     eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, NEW_FIRMWARE_STATUS_SIZE_ADDRESS, sizeof(uint32_t), (uint8_t *)&new_firmware_status.newFirmwareSize);
-    INT_SYS_EnableIRQGlobal();
+    flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_SIZE_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
     if( eeprom_status != STATUS_SUCCESS )
 	{
 		return false;
 	}
 
 	// Write new firmware checksum
-	// Critical section where all interrupts are forbiden.
-	INT_SYS_DisableIRQGlobal();
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
     eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS, sizeof(uint32_t), (uint8_t *)&new_firmware_status.newFirmwareChecksum);
-    INT_SYS_EnableIRQGlobal();
+    flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_CHECKSUM_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
     if( eeprom_status != STATUS_SUCCESS )
 	{
 		return false;
 	}
+
+#ifdef FIRMWARE_AB_SLOTS
+	if( !eeprom_write_active_slot() )
+	{
+		return false;
+	}
+#endif
+	return eeprom_write_install_journal();
+}
+
+#ifdef FIRMWARE_AB_SLOTS
+/*
+ * Write the active firmware slot to EEPROM
+ */
+bool eeprom_write_active_slot(void)
+{
+	status_t eeprom_status = STATUS_SUCCESS;
+
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
+	eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS, sizeof(uint8_t), (uint8_t *)&new_firmware_status.activeFirmwareSlot);
+	flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	if( eeprom_status != STATUS_SUCCESS )
+	{
+		return false;
+	}
+	return true;
+}
+#endif
+
+/*
+ * Write the install journal (the number of old firmware sectors already overwritten) to EEPROM
+ */
+bool eeprom_write_install_journal(void)
+{
+	status_t eeprom_status = STATUS_SUCCESS;
+
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_INSTALLED_SECTORS_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
+	eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, NEW_FIRMWARE_STATUS_INSTALLED_SECTORS_ADDRESS, sizeof(uint32_t), (uint8_t *)&new_firmware_status.installedSectorNum);
+	flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, NEW_FIRMWARE_STATUS_INSTALLED_SECTORS_ADDRESS - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	if( eeprom_status != STATUS_SUCCESS )
+	{
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Write the resume point of the download to EEPROM, unless it is already stored
+ * (it is rewritten once per sector of the download at most).
+ */
+bool eeprom_write_resume_point(uint32_t resumeOffset, uint32_t imageId)
+{
+#ifdef FLASH_USE_PROGRAM_SECTION
+	// FlexRAM may still be the section program buffer during a download.
+	if( flash_engine_set_section_buffer(false) == false )
+	{
+		return false;
+	}
+#endif
+	if (flashSSDConfig.EEESize == 0u)
+	{
+		// No Emulated EEPROM is assigned
+		return false;
+	}
+
+	if( eeprom_update_word(NEW_FIRMWARE_RESUME_IMAGE_ID_ADDRESS, imageId) == false )
+	{
+		return false;
+	}
+	return eeprom_update_word(NEW_FIRMWARE_RESUME_OFFSET_ADDRESS, resumeOffset);
+}
+
+/*
+ * Write a 32-bit word to EEPROM, unless it already holds the value.
+ * @param:
+ * 		address: word aligned EEPROM (FlexRAM) address
+ */
+bool eeprom_update_word(uint32_t address, uint32_t value)
+{
+	status_t eeprom_status = STATUS_SUCCESS;
+
+	if( *((uint32_t *)MEMORY_ADDRESS(address)) == value )
+	{
+		return true;
+	}
+	// Critical section where only the RAM-resident interrupts are served.
+	TRACE_BEGIN(TRACE_EVENT_EEPROM_WRITE, address - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	flash_engine_mask_irq();
+	eeprom_status = FLASH_DRV_EEEWrite(&flashSSDConfig, address, sizeof(uint32_t), (uint8_t *)&value);
+	flash_engine_unmask_irq();
+	TRACE_END(TRACE_EVENT_EEPROM_WRITE, address - NEW_FIRMWARE_STATUS_START_ADDRESS);
+	if( eeprom_status != STATUS_SUCCESS )
+	{
+		return false;
+	}
 	return true;
 }
 
+#ifdef FIRMWARE_FAST_BOOT
+/*
+ * Write the validation record of a just verified firmware to EEPROM and restart the boot count.
+ * The record carries the slot of the firmware, so it does not apply to the other slot
+ * if the power fails before that slot is activated.
+ * @param:
+ * 		firmwareSize, firmwareChecksum: the size and CRC-32 of the validated firmware
+ * 		firmwareSlot: the slot of the validated firmware (FIRMWARE_SLOT_A without FIRMWARE_AB_SLOTS)
+ */
+bool eeprom_write_validation(uint32_t firmwareSize, uint32_t firmwareChecksum, uint8_t firmwareSlot)
+{
+	if (flashSSDConfig.EEESize == 0u)
+	{
+		// No Emulated EEPROM is assigned
+		return false;
+	}
+	firmware_BootCount.count = 0u;
+	if( (eeprom_update_word(FIRMWARE_VALIDATED_SLOT_ADDRESS, firmwareSlot) == false) ||
+		(eeprom_update_word(FIRMWARE_VALIDATED_SIZE_ADDRESS, firmwareSize) == false) ||
+		(eeprom_update_word(FIRMWARE_VALIDATED_CHECKSUM_ADDRESS, firmwareChecksum) == false) )
+	{
+		return false;
+	}
+	return eeprom_update_word(FIRMWARE_VERIFY_REQUEST_ADDRESS, 0u);
+}
+
+/*
+ * @return:
+ * 		true if the EEPROM holds a validation record of the firmware in the active slot
+ */
+bool isValidationRecordActive(void)
+{
+	// The erased EEPROM (0xFFFFFFFF) is slot A, as the active slot.
+	uint8_t firmwareSlot = (*((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_SLOT_ADDRESS)) == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_B : FIRMWARE_SLOT_A;
+
+	return ( (*((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_SIZE_ADDRESS)) <= OLD_FIRMWARE_MAX_SIZE) &&
+			 (firmwareSlot == new_firmware_status.activeFirmwareSlot) );
+}
+#endif
+
 void firmware_update_test(void)
 {
 	char InputChar = 'n';
@@ -637,8 +1220,9 @@ void firmware_update_test(void)
 		}
 		printf("End new firmware update...\r\n");
 
-		// After the new firmware is copied to overwrite the old firmware, clear the update flag.
+		// After the new firmware is copied to overwrite the old firmware, clear the update flag and the install journal.
 		new_firmware_status.isNewFirmwareUpdated = 0u;
+		new_firmware_status.installedSectorNum = 0u;
 
 		// Store the new firmware status into EEPROM
 		retValue = eeprom_write_new_firmware_status();
@@ -665,10 +1249,10 @@ void firmware_update_test(void)
 		uint8_t i = 0;
 		for(i = 0; i < 7; i++)
 		{
-			retValue = flash_auto_write_64bytes();
+			retValue = flash_auto_write_bytes(rx_data_packet.item.raw_data, sizeof(test_text));
 			if(!retValue)
 			{
-				printf("fail to write 64 bytes data: %lu\r\n", flash_Write64BytesCount + 1);
+				printf("fail to write 64 bytes data at offset: %lu\r\n", (unsigned long)flash_WrittenBytesCount);
 				// fail in auto write
 				return;
 			}
@@ -701,6 +1285,8 @@ void firmware_update(void)
 //    FLASH_DRV_EraseAllBlock(&flashSSDConfig);
 	bool retValue = false;
 
+	TRACE_BEGIN(TRACE_EVENT_FIRMWARE_UPDATE, 0u);
+
 	retValue = eeprom_read_new_firmware_status();
 	if(!retValue)
 	{
@@ -710,6 +1296,30 @@ void firmware_update(void)
 		retValue = eeprom_read_new_firmware_status();
 	}
 
+#ifdef FIRMWARE_AB_SLOTS
+	if(new_firmware_status.isNewFirmwareUpdated == 1u)
+	{
+		// Boot the downloaded slot in place if it is valid, otherwise keep the active slot.
+		retValue = firmware_activate_download_slot();
+		if(!retValue)
+		{
+			// Write the status again if it failed. The update flag is only cleared once the slot is committed.
+			retValue = eeprom_write_new_firmware_status();
+		}
+	}
+#ifdef FIRMWARE_FAST_BOOT
+	if( !firmware_verify_active() && !firmware_fall_back() )
+	{
+		// The active firmware is corrupted and the other slot holds no firmware. Stay in the bootloader and wait for a download.
+		return;
+	}
+#endif
+	/*
+	 * If there exists a firmware in the active slot, jump to it and this function will never return.
+	 * If no firmware exists, this function will return.
+	 */
+	JumpToOldFirmware();
+#else
 	if(new_firmware_status.isNewFirmwareUpdated == 1u)
 	{
 #ifdef DEBUG_FROM_RAM
@@ -728,8 +1338,21 @@ void firmware_update(void)
 #ifdef DEBUG_FROM_RAM
 //		printf("End new firmware updating...\r\n");
 #endif
-		// After the new firmware is copied to overwrite the old firmware, clear the update flag.
+#ifdef FIRMWARE_FAST_BOOT
+		if(retValue)
+		{
+			// The installed firmware is just verified, the next boots take the fast path.
+			eeprom_write_validation(new_firmware_status.newFirmwareSize, new_firmware_status.newFirmwareChecksum, FIRMWARE_SLOT_A);
+		}
+		else
+		{
+			// The old firmware area may be half overwritten, verify it fully on the next boot.
+			eeprom_update_word(FIRMWARE_VERIFY_REQUEST_ADDRESS, 1u);
+		}
+#endif
+		// After the new firmware is copied to overwrite the old firmware, clear the update flag and the install journal.
 		new_firmware_status.isNewFirmwareUpdated = 0u;
+		new_firmware_status.installedSectorNum = 0u;
 
 		// Store the new firmware status into EEPROM
 		retValue = eeprom_write_new_firmware_status();
@@ -755,6 +1378,13 @@ void firmware_update(void)
 #ifdef DEBUG_FROM_RAM
 		printf("No firmware updated\r\n");
 		printf("Jump to old firmware\r\n");
+#endif
+#ifdef FIRMWARE_FAST_BOOT
+		if( !firmware_verify_active() && !firmware_fall_back() )
+		{
+			// The old firmware is corrupted and cannot be installed again. Stay in the bootloader and wait for a download.
+			return;
+		}
 #endif
 		/*
 		 * If there exists an old firmware, jump to the old firmware and this function will never return.
@@ -762,7 +1392,178 @@ void firmware_update(void)
 		 */
 		JumpToOldFirmware();
 	}
+#endif
+}
+
+#ifdef FIRMWARE_AB_SLOTS
+/*
+ * Make the downloaded slot the active slot, if its CRC-32 matches and it is linked for this slot.
+ * The update flag is cleared in any case, so an invalid download is not checked again.
+ *
+ * The slot write is the commit point of the activation, the update flag is only cleared after it.
+ * After a power loss in between, the next boot checks the other slot (the previous firmware) against the
+ * download and only clears the flag, so the activated slot stays active.
+ * @return:
+ * 		false if the status cannot be written to EEPROM
+ */
+bool firmware_activate_download_slot(void)
+{
+	uint32_t downloadStartAddress = DOWNLOAD_FIRMWARE_START_ADDRESS;
+	uint8_t activeFirmwareSlot = new_firmware_status.activeFirmwareSlot;
+
+	if( (new_firmware_status.newFirmwareSize <= NEW_FIRMWARE_MAX_SIZE) &&
+		(flash_calculate_image_crc32(downloadStartAddress, new_firmware_status.newFirmwareSize) == new_firmware_status.newFirmwareChecksum) &&
+		isFirmwareEntryValid(downloadStartAddress) )
+	{
+#ifdef FIRMWARE_FAST_BOOT
+		// Just verified, the next boots take the fast path. The record names the slot, it only applies once the slot is active.
+		eeprom_write_validation(new_firmware_status.newFirmwareSize, new_firmware_status.newFirmwareChecksum,
+								(activeFirmwareSlot == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_A : FIRMWARE_SLOT_B);
+#endif
+		new_firmware_status.activeFirmwareSlot = (activeFirmwareSlot == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_A : FIRMWARE_SLOT_B;
+		if( !eeprom_write_active_slot() )
+		{
+			// Not committed, the update flag stays set and the activation is retried on the next boot.
+			new_firmware_status.activeFirmwareSlot = activeFirmwareSlot;
+			return false;
+		}
+	}
+	new_firmware_status.isNewFirmwareUpdated = 0u;
+
+	// Store the firmware status into EEPROM
+	return eeprom_write_new_firmware_status();
 }
+#endif
+
+#ifdef FIRMWARE_FAST_BOOT
+/*
+ * Fast path of the boot decision, called right after reset before flash_init().
+ * The firmware is started without scanning the image, if
+ * 		- no new firmware waits to be installed or activated,
+ * 		- the active firmware has a validation record and no full verification is requested,
+ * 		- less than FIRMWARE_FULL_VERIFY_INTERVAL boots have passed since it was fully verified,
+ * 		- and its entry vector is valid.
+ * It reads a few words from the emulated EEPROM, which the reset has already loaded into FlexRAM, and counts the
+ * boot in RAM, so it writes no EEPROM record and needs no flash driver initialization.
+ * @param:
+ * 		isPowerLost: a power loss since the last boot, the boot count in RAM is undefined and the firmware is
+ * 					 verified fully once
+ * This function never returns if the fast path is taken, otherwise firmware_update() decides.
+ */
+void firmware_fast_boot(bool isPowerLost)
+{
+	TRACE_BEGIN(TRACE_EVENT_FAST_BOOT, 0u);
+	if( isPowerLost || (firmware_BootCount.magic != FIRMWARE_BOOT_COUNT_MAGIC) )
+	{
+		// The boot count is unknown, take the slow path once. firmware_verify_active() restarts the count.
+		firmware_BootCount.magic = FIRMWARE_BOOT_COUNT_MAGIC;
+		firmware_BootCount.count = FIRMWARE_FULL_VERIFY_INTERVAL;
+	}
+	if( (FTFC->FCNFG & FTFC_FCNFG_EEERDY_MASK) == 0u )
+	{
+		// The emulated EEPROM is not available (not partitioned yet)
+		TRACE_END(TRACE_EVENT_FAST_BOOT, 0u);
+		return;
+	}
+	if( *((uint8_t *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_UPDATE_FLAG_ADDRESS)) == 1u )
+	{
+		// A new firmware waits to be installed
+		TRACE_END(TRACE_EVENT_FAST_BOOT, 0u);
+		return;
+	}
+#ifdef FIRMWARE_AB_SLOTS
+	new_firmware_status.activeFirmwareSlot = (*((uint8_t *)MEMORY_ADDRESS(NEW_FIRMWARE_STATUS_ACTIVE_SLOT_ADDRESS)) == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_B : FIRMWARE_SLOT_A;
+#endif
+	if( !isValidationRecordActive() ||
+		(*((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VERIFY_REQUEST_ADDRESS)) != 0u) ||
+		(firmware_BootCount.count >= FIRMWARE_FULL_VERIFY_INTERVAL) )
+	{
+		// No validation record of the active firmware, or the full verification is due
+		TRACE_END(TRACE_EVENT_FAST_BOOT, 0u);
+		return;
+	}
+	if( !isFirmwareEntryValid(ACTIVE_FIRMWARE_START_ADDRESS) )
+	{
+		TRACE_END(TRACE_EVENT_FAST_BOOT, 0u);
+		return;
+	}
+
+	firmware_BootCount.count++;
+	// arg 1: the fast path is taken
+	TRACE_END(TRACE_EVENT_FAST_BOOT, 1u);
+	JumpToFirmware(ACTIVE_FIRMWARE_START_ADDRESS);
+}
+
+/*
+ * Full verification of the active firmware against its validation record.
+ * A firmware without a validation record (e.g. programmed by the debugger) is only checked by its entry vector.
+ * @return:
+ * 		false if the CRC-32 of the active firmware does not match its validation record
+ */
+bool firmware_verify_active(void)
+{
+	uint32_t firmwareSize = 0;
+	uint32_t firmwareChecksum = 0;
+
+	if (flashSSDConfig.EEESize == 0u)
+	{
+		// No Emulated EEPROM is assigned
+		return true;
+	}
+	if( !isValidationRecordActive() )
+	{
+		// No validation record, or the record of the other slot which was never activated
+		return true;
+	}
+	firmwareSize = *((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_SIZE_ADDRESS));
+	firmwareChecksum = *((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_CHECKSUM_ADDRESS));
+	if( flash_calculate_image_crc32(ACTIVE_FIRMWARE_START_ADDRESS, firmwareSize) != firmwareChecksum )
+	{
+		return false;
+	}
+	// Verified, the next boots take the fast path again. The EEPROM is only written if a verification was requested.
+	firmware_BootCount.count = 0u;
+	eeprom_update_word(FIRMWARE_VERIFY_REQUEST_ADDRESS, 0u);
+	return true;
+}
+
+/*
+ * Fall back to an intact firmware after the active firmware failed its verification.
+ * With FIRMWARE_AB_SLOTS the other slot is activated if it holds a firmware linked for it.
+ * Without it the old firmware area is installed again from the new firmware area, if that
+ * still holds the validated firmware.
+ * @return:
+ * 		true if the active firmware can be started
+ */
+bool firmware_fall_back(void)
+{
+#ifdef FIRMWARE_AB_SLOTS
+	if( !isFirmwareEntryValid(DOWNLOAD_FIRMWARE_START_ADDRESS) )
+	{
+		return false;
+	}
+	// The other slot has no validation record, it is verified by its entry vector only.
+	new_firmware_status.activeFirmwareSlot = (new_firmware_status.activeFirmwareSlot == FIRMWARE_SLOT_B) ? FIRMWARE_SLOT_A : FIRMWARE_SLOT_B;
+	return eeprom_write_active_slot();
+#else
+	if( (*((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_SIZE_ADDRESS)) != new_firmware_status.newFirmwareSize) ||
+		(*((uint32_t *)MEMORY_ADDRESS(FIRMWARE_VALIDATED_CHECKSUM_ADDRESS)) != new_firmware_status.newFirmwareChecksum) )
+	{
+		// The new firmware area holds another firmware, or a download has started to overwrite it.
+		return false;
+	}
+	// Copy the whole firmware again, flash_overwrite_old_firmware() checks the CRC of the new firmware first.
+	new_firmware_status.installedSectorNum = 0u;
+	if( !flash_overwrite_old_firmware() )
+	{
+		return false;
+	}
+	new_firmware_status.installedSectorNum = 0u;
+	return ( eeprom_write_install_journal() &&
+			 eeprom_write_validation(new_firmware_status.newFirmwareSize, new_firmware_status.newFirmwareChecksum, FIRMWARE_SLOT_A) );
+#endif
+}
+#endif
 
 /*
  * @brief: Used to jump to the entry point of the old firmware application
@@ -771,40 +1572,70 @@ void firmware_update(void)
  */
 void JumpToOldFirmware(void)
 {
-	// Local variables
-	uint32_t * startAddress = (uint32_t *)OLD_FIRMWARE_START_ADDRESS;
-	uint32_t userStackPointer = 0u;
-	uint32_t userProgramCounter = 0u;
+	// The old firmware area, or the active slot with FIRMWARE_AB_SLOTS
+	JumpToFirmware(ACTIVE_FIRMWARE_START_ADDRESS);
+}
 
-	// Important: After you read a 32-bits word from flash, you must convert it from little-endian to big-endian...
-	// The first 32-bits word in the old firmware start address is loaded into stack pointer (SP)
-//	userStackPointer = LE2BE_32(startAddress[0]);
-	// The second 32-bits word in the old firmware start address is loaded into program counter (PC)
-//	userProgramCounter = LE2BE_32(startAddress[1]);
+/*
+ * Check the entry vector (stack pointer and reset vector) of the firmware.
+ * The reset vector also tells if the firmware is linked for this start address.
+ */
+bool isFirmwareEntryValid(uint32_t firmwareStartAddress)
+{
+	uint32_t * startAddress = (uint32_t *)MEMORY_ADDRESS(firmwareStartAddress);
+	uint32_t userStackPointer = startAddress[0];
+	uint32_t userProgramCounter = startAddress[1];
 
-	userStackPointer = startAddress[0];
-	userProgramCounter = startAddress[1];
 	/*
-	 * Check if the word in entry address is erased,
-	 * and return if erased.
+	 * Check if the word in entry address is erased.
 	 */
 	if( userStackPointer == 0xFFFFFFFF )
 	{
-		return;
+		return false;
 	}
 
-	if( userStackPointer != 0x20007000 )
+	if( userStackPointer != FIRMWARE_STACK_POINTER )
 	{
 		// The stack pointer must point to the top of stack, that is, the buttom of SRAM_U.
-		return;
+		return false;
 	}
 
 	/*
 	 * PC offset = 0x411
 	 */
-	if( userProgramCounter != (OLD_FIRMWARE_START_ADDRESS + 0x00000411) )
+	if( userProgramCounter != (firmwareStartAddress + FIRMWARE_RESET_HANDLER_OFFSET) )
 	{
 		// The program counter must point to the reset handler entry address (firmware start address + offset).
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Jump to the firmware at the start address.
+ * This function never returns if the firmware entry vector is valid.
+ */
+void JumpToFirmware(uint32_t firmwareStartAddress)
+{
+	// Local variables
+	uint32_t * startAddress = (uint32_t *)MEMORY_ADDRESS(firmwareStartAddress);
+	uint32_t userStackPointer = 0u;
+	uint32_t userProgramCounter = 0u;
+
+	// Important: After you read a 32-bits word from flash, you must convert it from little-endian to big-endian...
+	// The first 32-bits word in the old firmware start address is loaded into stack pointer (SP)
+//	userStackPointer = LE2BE_32(startAddress[0]);
+	// The second 32-bits word in the old firmware start address is loaded into program counter (PC)
+//	userProgramCounter = LE2BE_32(startAddress[1]);
+
+	userStackPointer = startAddress[0];
+	userProgramCounter = startAddress[1];
+	/*
+	 * Check if the entry vector is valid,
+	 * and return if not (e.g. erased).
+	 */
+	if( !isFirmwareEntryValid(firmwareStartAddress) )
+	{
 		return;
 	}
 
@@ -824,8 +1655,9 @@ void JumpToOldFirmware(void)
 	 *
 	 */
 
+	TRACE_EVENT(TRACE_EVENT_JUMP, 0u);
 	/* Relocate vector table in vector table offset register */
-	S32_SCB->VTOR = (uint32_t)startAddress;
+	S32_SCB->VTOR = firmwareStartAddress;
 
 	JumpToExecute(userStackPointer, userProgramCounter);
 }
@@ -838,12 +1670,12 @@ void JumpToOldFirmware(void)
 void auto_ram_reset(void)
 {
 	// Local variables
-	uint32_t *startAddress = (uint32_t *) 0x1FFF8000u;
+	uint32_t *startAddress = (uint32_t *)MEMORY_ADDRESS(0x1FFF8000u);
 	uint32_t stackPointer = startAddress[0];
 	uint32_t programCounter = startAddress[1];
 
 	/* Relocate vector table in vector table offset register */
-	S32_SCB->VTOR = (uint32_t)startAddress;
+	S32_SCB->VTOR = 0x1FFF8000u;
 
 	JumpToExecute(stackPointer, programCounter);
 }
@@ -856,18 +1688,22 @@ void auto_ram_reset(void)
 void auto_flash_reset(void)
 {
 	// Local variables
-	uint32_t *startAddress = (uint32_t *) 0x00000000u;
+	uint32_t *startAddress = (uint32_t *)MEMORY_ADDRESS(0x00000000u);
 	uint32_t stackPointer = startAddress[0];
 	uint32_t programCounter = startAddress[1];
 
 	/* Relocate vector table in vector table offset register */
-	S32_SCB->VTOR = (uint32_t)startAddress;
+	S32_SCB->VTOR = 0x00000000u;
 
 	JumpToExecute(stackPointer, programCounter);
 }
 
 void JumpToExecute(uint32_t stack_pointer, uint32_t program_counter)
 {
+#ifdef HOST_SIMULATION
+	// The simulator restarts itself for the bootloader reset vector, or stops at the firmware entry.
+	sim_jump(stack_pointer, program_counter);
+#else
 	// Register r0 holds argument 0 stack_pointer
 	// Register r1 holds argument 1 program counter
 	/* Set up stack pointer (SP) */
@@ -875,11 +1711,12 @@ void JumpToExecute(uint32_t stack_pointer, uint32_t program_counter)
 //	__asm("msr psp, r0");
 	/* Program counter (PC) jumps to application start address (r1) */
 	__asm("mov pc, r1");
+#endif
 }
 
 void printOldFirmware(void)
 {
-	uint8_t * startAddress = (uint8_t *) OLD_FIRMWARE_START_ADDRESS;
+	uint8_t * startAddress = (uint8_t *)MEMORY_ADDRESS(OLD_FIRMWARE_START_ADDRESS);
 	uint32_t i = 0;
 	printf("Current firmware to execute:");
 	for(i = 0; i < new_firmware_status.newFirmwareSize; i++)
@@ -0,0 +1,160 @@
+/*
+ * crc32.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "crc32.h"
+#include "stddef.h"
+#ifndef CRC32_USE_SOFTWARE
+#include "Cpu.h"
+#endif
+
+#ifdef CRC32_USE_SOFTWARE
+/*
+ * Slice-by-4 tables, generated by crc32_init().
+ * crc32_Table[0] is the classic byte table, crc32_Table[k] advances the CRC over k more zero bytes.
+ */
+static uint32_t crc32_Table[4][256];
+static uint32_t crc32_Value = CRC32_SEED;
+#endif
+
+/*
+ * Initialize the CRC calculation.
+ * 		hardware: enable the clock of the CRC module
+ * 		software: generate the slice-by-4 tables
+ */
+void crc32_init(void)
+{
+#ifdef CRC32_USE_SOFTWARE
+	uint32_t i = 0;
+	uint32_t bit = 0;
+	uint32_t crc = 0;
+
+	for( i = 0; i < 256u; i++ )
+	{
+		crc = i;
+		for( bit = 0; bit < 8u; bit++ )
+		{
+			crc = (crc & 1u) ? ((crc >> 1) ^ CRC32_POLYNOMIAL_REFLECTED) : (crc >> 1);
+		}
+		crc32_Table[0][i] = crc;
+	}
+	for( i = 0; i < 256u; i++ )
+	{
+		crc32_Table[1][i] = (crc32_Table[0][i] >> 8) ^ crc32_Table[0][crc32_Table[0][i] & 0xFFu];
+		crc32_Table[2][i] = (crc32_Table[1][i] >> 8) ^ crc32_Table[0][crc32_Table[1][i] & 0xFFu];
+		crc32_Table[3][i] = (crc32_Table[2][i] >> 8) ^ crc32_Table[0][crc32_Table[2][i] & 0xFFu];
+	}
+#else
+	PCC->PCCn[PCC_CRC_INDEX] |= PCC_PCCn_CGC_MASK;
+#endif
+}
+
+/*
+ * Start a new CRC calculation with the seed.
+ */
+void crc32_start(void)
+{
+#ifdef CRC32_USE_SOFTWARE
+	crc32_Value = CRC32_SEED;
+#else
+	/*
+	 * 32-bit CRC, the written data are transposed in bits and bytes (reflected input),
+	 * the read result is transposed in bits and bytes (reflected output) and XORed with 0xFFFFFFFF.
+	 */
+	CRC->CTRL = CRC_CTRL_TCRC_MASK | CRC_CTRL_TOT(2u) | CRC_CTRL_TOTR(2u) | CRC_CTRL_FXOR_MASK;
+	CRC->GPOLY = CRC32_POLYNOMIAL;
+	// Write the seed while WAS is set
+	CRC->CTRL |= CRC_CTRL_WAS_MASK;
+	CRC->DATAu.DATA = CRC32_SEED;
+	CRC->CTRL &= ~CRC_CTRL_WAS_MASK;
+#endif
+}
+
+/*
+ * Continue the CRC calculation over the data.
+ * The data are read 32 bits at a time, except the unaligned head and the tail.
+ * @param:
+ * 		pData: the data, e.g. a firmware image in flash
+ * 		byteNum: the number of bytes
+ */
+void crc32_update(const uint8_t * pData, uint32_t byteNum)
+{
+	const uint32_t * pWord = NULL;
+	uint32_t word = 0;
+#ifdef CRC32_USE_SOFTWARE
+	uint32_t crc = crc32_Value;
+#endif
+
+	if( pData == NULL )
+	{
+		return;
+	}
+
+	// The unaligned head, byte by byte
+	while( (byteNum > 0u) && (((uintptr_t)pData & 3u) != 0u) )
+	{
+#ifdef CRC32_USE_SOFTWARE
+		crc = (crc >> 8) ^ crc32_Table[0][(crc ^ *pData) & 0xFFu];
+#else
+		CRC->DATAu.DATA_8.LL = *pData;
+#endif
+		pData++;
+		byteNum--;
+	}
+
+	// The aligned body, word by word (the words are little-endian)
+	pWord = (const uint32_t *)pData;
+	while( byteNum >= 4u )
+	{
+		word = *pWord++;
+#ifdef CRC32_USE_SOFTWARE
+		crc ^= word;
+		crc = crc32_Table[3][crc & 0xFFu] ^
+			  crc32_Table[2][(crc >> 8) & 0xFFu] ^
+			  crc32_Table[1][(crc >> 16) & 0xFFu] ^
+			  crc32_Table[0][crc >> 24];
+#else
+		CRC->DATAu.DATA = word;
+#endif
+		byteNum -= 4u;
+	}
+
+	// The tail, byte by byte
+	pData = (const uint8_t *)pWord;
+	while( byteNum > 0u )
+	{
+#ifdef CRC32_USE_SOFTWARE
+		crc = (crc >> 8) ^ crc32_Table[0][(crc ^ *pData) & 0xFFu];
+#else
+		CRC->DATAu.DATA_8.LL = *pData;
+#endif
+		pData++;
+		byteNum--;
+	}
+
+#ifdef CRC32_USE_SOFTWARE
+	crc32_Value = crc;
+#endif
+}
+
+/*
+ * @return:
+ * 		the CRC of all data passed to crc32_update() since crc32_start()
+ */
+uint32_t crc32_result(void)
+{
+#ifdef CRC32_USE_SOFTWARE
+	return crc32_Value ^ 0xFFFFFFFFu;
+#else
+	return CRC->DATAu.DATA;
+#endif
+}
+
+uint32_t crc32_calculate(const uint8_t * pData, uint32_t byteNum)
+{
+	crc32_start();
+	crc32_update(pData, byteNum);
+	return crc32_result();
+}
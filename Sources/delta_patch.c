@@ -0,0 +1,300 @@
+/*
+ * delta_patch.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "delta_patch.h"
+#include "crc32.h"
+#include "string.h"
+
+/*
+ * Streaming delta patch decoder.
+ *
+ * The patch arrives in pieces (the payload of the PC data packets) and is decoded byte by byte,
+ * so an opcode or a literal may be split across data packets. The rebuilt new image is collected
+ * in the output block and handed to the write function whenever the block is full.
+ */
+
+typedef enum
+{
+	DELTA_PATCH_HEADER,			// Collect the header
+	DELTA_PATCH_OPCODE,			// Wait for the next opcode
+	DELTA_PATCH_COPY_ARGS,		// Collect offset and length of a copy
+	DELTA_PATCH_INSERT_ARGS,	// Collect length of an insert
+	DELTA_PATCH_INSERT_DATA,	// Output the literal bytes
+	DELTA_PATCH_DONE,			// The end opcode has been decoded
+	DELTA_PATCH_ERROR			// The patch is corrupted or the output cannot be written
+} DELTA_PATCH_STATE_t;
+
+static DELTA_PATCH_STATE_t delta_patch_State = DELTA_PATCH_HEADER;
+
+static const uint8_t * delta_patch_pOldImage = NULL;
+static uint32_t delta_patch_OldImageMaxSize = 0u;
+static DELTA_PATCH_WRITE_t delta_patch_pWrite = NULL;
+
+// The header or opcode arguments being collected
+static uint8_t delta_patch_Args[DELTA_PATCH_HEADER_SIZE];
+static uint32_t delta_patch_ArgsCount = 0u;
+
+static uint32_t delta_patch_OldImageSize = 0u;
+static uint32_t delta_patch_NewImageSize = 0u;
+static uint32_t delta_patch_NewImageChecksum = 0u;
+static uint32_t delta_patch_InsertRemaining = 0u;
+
+// The output block is word aligned for the flash writing
+static uint32_t delta_patch_OutputBlock[DELTA_PATCH_OUTPUT_BLOCK_SIZE / 4u];
+static uint32_t delta_patch_OutputCount = 0u;		// The number of bytes in the output block
+static uint32_t delta_patch_OutputTotal = 0u;		// The number of new image bytes output so far
+
+/*
+ * Private Function Prototype
+ */
+static uint32_t delta_patch_get_u32(const uint8_t * pBytes);
+static bool delta_patch_output_byte(uint8_t outputByte);
+static bool delta_patch_decode_header(void);
+static bool delta_patch_decode_copy(void);
+
+/*
+ * Restart the decoder for a new download.
+ * @param:
+ * 		pOldImage: the start of the installed firmware
+ * 		oldImageMaxSize: the size of the installed firmware area
+ * 		pWrite: the function writing the output blocks of the new image
+ */
+void delta_patch_reset(const uint8_t * pOldImage, uint32_t oldImageMaxSize, DELTA_PATCH_WRITE_t pWrite)
+{
+	delta_patch_State = DELTA_PATCH_HEADER;
+	delta_patch_pOldImage = pOldImage;
+	delta_patch_OldImageMaxSize = oldImageMaxSize;
+	delta_patch_pWrite = pWrite;
+	delta_patch_ArgsCount = 0u;
+	delta_patch_OldImageSize = 0u;
+	delta_patch_NewImageSize = 0u;
+	delta_patch_NewImageChecksum = 0u;
+	delta_patch_InsertRemaining = 0u;
+	delta_patch_OutputCount = 0u;
+	delta_patch_OutputTotal = 0u;
+}
+
+/*
+ * Decode the next piece of the patch.
+ * @param:
+ * 		pData: the patch bytes
+ * 		byteNum: the number of patch bytes
+ * @return:
+ * 		true:	the patch bytes are decoded and the full output blocks are written
+ * 		false:	the patch is corrupted, does not match the old image or the write has failed
+ */
+bool delta_patch_input(const uint8_t * pData, uint32_t byteNum)
+{
+	uint32_t i = 0;
+	uint8_t patchByte = 0;
+
+	if( (pData == NULL) || (delta_patch_pWrite == NULL) || (delta_patch_pOldImage == NULL) )
+	{
+		return false;
+	}
+
+	for( i = 0; i < byteNum; i++ )
+	{
+		patchByte = pData[i];
+		switch( delta_patch_State )
+		{
+			case DELTA_PATCH_HEADER:
+				delta_patch_Args[delta_patch_ArgsCount++] = patchByte;
+				if( delta_patch_ArgsCount == DELTA_PATCH_HEADER_SIZE )
+				{
+					delta_patch_ArgsCount = 0u;
+					delta_patch_State = delta_patch_decode_header() ? DELTA_PATCH_OPCODE : DELTA_PATCH_ERROR;
+				}
+				break;
+
+			case DELTA_PATCH_OPCODE:
+				if( patchByte == DELTA_PATCH_OP_COPY )
+				{
+					delta_patch_State = DELTA_PATCH_COPY_ARGS;
+				}
+				else if( patchByte == DELTA_PATCH_OP_INSERT )
+				{
+					delta_patch_State = DELTA_PATCH_INSERT_ARGS;
+				}
+				else if( patchByte == DELTA_PATCH_OP_END )
+				{
+					delta_patch_State = DELTA_PATCH_DONE;
+				}
+				else
+				{
+					// Unknown opcode
+					delta_patch_State = DELTA_PATCH_ERROR;
+				}
+				break;
+
+			case DELTA_PATCH_COPY_ARGS:
+				delta_patch_Args[delta_patch_ArgsCount++] = patchByte;
+				if( delta_patch_ArgsCount == 8u )
+				{
+					delta_patch_ArgsCount = 0u;
+					delta_patch_State = delta_patch_decode_copy() ? DELTA_PATCH_OPCODE : DELTA_PATCH_ERROR;
+				}
+				break;
+
+			case DELTA_PATCH_INSERT_ARGS:
+				delta_patch_Args[delta_patch_ArgsCount++] = patchByte;
+				if( delta_patch_ArgsCount == 2u )
+				{
+					delta_patch_ArgsCount = 0u;
+					delta_patch_InsertRemaining = (uint32_t)delta_patch_Args[0] | ((uint32_t)delta_patch_Args[1] << 8);
+					delta_patch_State = (delta_patch_InsertRemaining == 0u) ? DELTA_PATCH_OPCODE : DELTA_PATCH_INSERT_DATA;
+				}
+				break;
+
+			case DELTA_PATCH_INSERT_DATA:
+				if( !delta_patch_output_byte(patchByte) )
+				{
+					delta_patch_State = DELTA_PATCH_ERROR;
+					break;
+				}
+				delta_patch_InsertRemaining--;
+				if( delta_patch_InsertRemaining == 0u )
+				{
+					delta_patch_State = DELTA_PATCH_OPCODE;
+				}
+				break;
+
+			case DELTA_PATCH_DONE:
+			default:
+				// No patch byte is allowed after the end opcode.
+				delta_patch_State = DELTA_PATCH_ERROR;
+				break;
+		}
+
+		if( delta_patch_State == DELTA_PATCH_ERROR )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Write the last output block after the whole patch has been received.
+ * The last block is padded with 0xFF to the flash phrase size.
+ * @return:
+ * 		true if the new image is complete and its checksum matches the patch header
+ */
+bool delta_patch_finish(void)
+{
+	uint8_t * pOutputBlock = (uint8_t *)delta_patch_OutputBlock;
+
+	if( delta_patch_State != DELTA_PATCH_DONE )
+	{
+		return false;
+	}
+	if( delta_patch_OutputTotal != delta_patch_NewImageSize )
+	{
+		return false;
+	}
+	crc32_update(pOutputBlock, delta_patch_OutputCount);
+	if( crc32_result() != delta_patch_NewImageChecksum )
+	{
+		return false;
+	}
+	if( delta_patch_OutputCount > 0u )
+	{
+		while( (delta_patch_OutputCount % 8u) != 0u )
+		{
+			pOutputBlock[delta_patch_OutputCount++] = 0xFFu;
+		}
+		if( !delta_patch_pWrite(pOutputBlock, delta_patch_OutputCount) )
+		{
+			return false;
+		}
+		delta_patch_OutputCount = 0u;
+	}
+	return true;
+}
+
+static uint32_t delta_patch_get_u32(const uint8_t * pBytes)
+{
+	return ((uint32_t)pBytes[0]) |
+		   ((uint32_t)pBytes[1] << 8) |
+		   ((uint32_t)pBytes[2] << 16) |
+		   ((uint32_t)pBytes[3] << 24);
+}
+
+/*
+ * Append one byte of the new image to the output block, write the block when it is full.
+ */
+static bool delta_patch_output_byte(uint8_t outputByte)
+{
+	uint8_t * pOutputBlock = (uint8_t *)delta_patch_OutputBlock;
+
+	if( delta_patch_OutputTotal >= delta_patch_NewImageSize )
+	{
+		// More output than announced in the header
+		return false;
+	}
+	pOutputBlock[delta_patch_OutputCount++] = outputByte;
+	delta_patch_OutputTotal++;
+
+	if( delta_patch_OutputCount == DELTA_PATCH_OUTPUT_BLOCK_SIZE )
+	{
+		delta_patch_OutputCount = 0u;
+		crc32_update(pOutputBlock, DELTA_PATCH_OUTPUT_BLOCK_SIZE);
+		return delta_patch_pWrite(pOutputBlock, DELTA_PATCH_OUTPUT_BLOCK_SIZE);
+	}
+	return true;
+}
+
+/*
+ * Check the header and that the installed firmware is the one the patch was made against.
+ */
+static bool delta_patch_decode_header(void)
+{
+	if( (delta_patch_Args[0] != (uint8_t)DELTA_PATCH_MAGIC_0) ||
+		(delta_patch_Args[1] != (uint8_t)DELTA_PATCH_MAGIC_1) ||
+		(delta_patch_Args[2] != DELTA_PATCH_VERSION) )
+	{
+		return false;
+	}
+	delta_patch_OldImageSize = delta_patch_get_u32(&delta_patch_Args[4]);
+	delta_patch_NewImageSize = delta_patch_get_u32(&delta_patch_Args[12]);
+	delta_patch_NewImageChecksum = delta_patch_get_u32(&delta_patch_Args[16]);
+	if( delta_patch_OldImageSize > delta_patch_OldImageMaxSize )
+	{
+		return false;
+	}
+
+	if( crc32_calculate(delta_patch_pOldImage, delta_patch_OldImageSize) != delta_patch_get_u32(&delta_patch_Args[8]) )
+	{
+		// The patch is made against another firmware.
+		return false;
+	}
+	// Start the CRC of the new image
+	crc32_start();
+	return true;
+}
+
+/*
+ * Output a block of the old image.
+ */
+static bool delta_patch_decode_copy(void)
+{
+	uint32_t offset = delta_patch_get_u32(&delta_patch_Args[0]);
+	uint32_t length = delta_patch_get_u32(&delta_patch_Args[4]);
+	uint32_t i = 0;
+
+	if( (offset > delta_patch_OldImageSize) || (length > (delta_patch_OldImageSize - offset)) )
+	{
+		return false;
+	}
+	for( i = 0; i < length; i++ )
+	{
+		if( !delta_patch_output_byte(delta_patch_pOldImage[offset + i]) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
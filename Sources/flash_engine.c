@@ -0,0 +1,445 @@
+/*
+ * flash_engine.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "flash_engine.h"
+#include "bootloader.h"
+#include "Cpu.h"
+#include "system_config.h"
+
+/*
+ * Interrupt-driven flash command queue.
+ *
+ * The flash jobs (erase sector, program, blank check) are queued by flash_engine_submit(), started by
+ * flash_engine_wait() and run one after the other from the FTFC command complete interrupt (FTFC_IRQHandler),
+ * instead of spinning on CCIF with all interrupts disabled. Each finished job calls its callback from
+ * the interrupt. A program job is split into one command per 8-bytes phrase.
+ *
+ * Note:
+ * The S32K144 program flash is a single block without read-while-write support.
+ * While a P-Flash command is running, no code may be fetched from P-Flash. Therefore
+ * the FTFC interrupt handler, the UART RX interrupt handler, the job submission and the thread wait loop
+ * are placed in RAM (.code_ram), and every other interrupt is masked by BASEPRI
+ * (see flash_engine_mask_irq()) while the queue is running in flash_engine_wait().
+ * The callbacks are called before the next command is launched, so they may be in P-Flash.
+ *
+ * With FLASH_USE_PROGRAM_SECTION, the 16-bytes aligned middle of a data block is programmed
+ * by a single Program Section command from FlexRAM, and only the unaligned head and tail
+ * phrases are programmed by Program Phrase commands.
+ */
+
+// The BASEPRI value masking every interrupt less urgent than the FTFC command complete interrupt
+#define FLASH_ENGINE_BASEPRI		((INTERRUPT_PRIORITY_LEVEL_FLASH + 1u) << (8u - FEATURE_NVIC_PRIO_BITS))
+
+#define FLASH_ENGINE_FSTAT_ERROR_MASK	(FTFx_FSTAT_MGSTAT0_MASK | FTFx_FSTAT_FPVIOL_MASK | FTFx_FSTAT_ACCERR_MASK | FTFx_FSTAT_RDCOLERR_MASK)
+
+/*
+ * Job queue: the thread puts, the FTFC interrupt gets.
+ * A job leaves the queue after its callback, so the queue is empty when all jobs have finished.
+ */
+static FLASH_ENGINE_JOB_t flash_engine_Queue[FLASH_ENGINE_QUEUE_SIZE];
+static volatile uint32_t flash_engine_PutIndex = 0u;
+static volatile uint32_t flash_engine_GetIndex = 0u;
+
+static volatile uint32_t flash_engine_Address = 0u;			// The destination of the next phrase
+static volatile uint32_t flash_engine_RemainingBytes = 0u;	// The number of bytes not yet programmed
+static volatile uint32_t flash_engine_Offset = 0u;			// The offset of the next phrase in the job data
+static volatile bool flash_engine_Running = false;			// The command complete interrupt runs the queue
+static volatile bool flash_engine_Launched = false;			// A command of the current job has been launched
+static volatile bool flash_engine_Error = false;			// A job has failed since the queue was started
+#ifdef FLASH_USE_PROGRAM_SECTION
+static volatile bool flash_engine_UseSection = false;		// FlexRAM is available as the section program buffer
+#endif
+
+/*
+ * Private Function Prototype
+ */
+START_FUNCTION_DECLARATION_RAMSECTION
+bool flash_engine_submit(const FLASH_ENGINE_JOB_t * pJob)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+bool flash_engine_wait(void)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+static void flash_engine_start_job(const FLASH_ENGINE_JOB_t * pJob)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+static void flash_engine_finish_job(bool isSuccessful)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+static void flash_engine_launch_next(const FLASH_ENGINE_JOB_t * pJob)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+static void flash_engine_launch_phrase(const FLASH_ENGINE_JOB_t * pJob)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+#ifdef FLASH_USE_PROGRAM_SECTION
+START_FUNCTION_DECLARATION_RAMSECTION
+static void flash_engine_launch_section(const FLASH_ENGINE_JOB_t * pJob)
+END_FUNCTION_DECLARATION_RAMSECTION
+#endif
+
+START_FUNCTION_DECLARATION_RAMSECTION
+void FTFC_IRQHandler(void)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+/*
+ * Initialize the FTFC command complete interrupt.
+ * The interrupt is only enabled in the flash module while the engine is programming.
+ */
+void flash_engine_init(void)
+{
+	FLASH_DRV_DisableCmdCompleteInterupt();
+	INT_SYS_SetPriority(FTFC_IRQn, INTERRUPT_PRIORITY_LEVEL_FLASH);
+	INT_SYS_ClearPending(FTFC_IRQn);
+	INT_SYS_EnableIRQ(FTFC_IRQn);
+}
+
+/*
+ * Mask every interrupt that is less urgent than the flash engine.
+ * Only the RAM-resident UART RX and FTFC interrupt handlers can be served
+ * while a flash command is running.
+ */
+void flash_engine_mask_irq(void)
+{
+	uint32_t basepri = FLASH_ENGINE_BASEPRI;
+#ifdef HOST_SIMULATION
+	sim_irq_set_basepri(basepri);
+#else
+	__asm volatile ("msr basepri, %0" : : "r" (basepri) : "memory");
+#endif
+}
+
+void flash_engine_unmask_irq(void)
+{
+	uint32_t basepri = 0u;
+#ifdef HOST_SIMULATION
+	sim_irq_set_basepri(basepri);
+#else
+	__asm volatile ("msr basepri, %0" : : "r" (basepri) : "memory");
+#endif
+}
+
+bool flash_engine_is_busy(void)
+{
+	return (flash_engine_PutIndex != flash_engine_GetIndex);
+}
+
+#ifdef FLASH_USE_PROGRAM_SECTION
+/*
+ * Switch FlexRAM between the section program buffer (RAM) and the Emulated EEPROM.
+ * @param:
+ * 		enable: true to use FlexRAM as the section program buffer, false to restore the Emulated EEPROM
+ */
+bool flash_engine_set_section_buffer(bool enable)
+{
+	status_t flash_status = STATUS_SUCCESS;
+
+	if( flash_engine_is_busy() )
+	{
+		return false;
+	}
+	if( enable == flash_engine_UseSection )
+	{
+		return true;
+	}
+
+	flash_engine_mask_irq();
+	flash_status = FLASH_DRV_SetFlexRamFunction(&flashSSDConfig, (enable ? EEE_DISABLE : EEE_ENABLE), 0u, NULL);
+	flash_engine_unmask_irq();
+	if( flash_status != STATUS_SUCCESS )
+	{
+		return false;
+	}
+
+	flash_engine_UseSection = enable;
+	return true;
+}
+#endif
+
+/*
+ * Queue a flash job (thread only). The queued jobs are started by flash_engine_wait(), so a batch of jobs
+ * runs back to back from the interrupt without the thread in between.
+ * @param:
+ * 		pJob: the job, copied into the queue
+ * @return:
+ * 		true:	the job is queued
+ * 		false:	invalid job, or the queue is full
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+bool flash_engine_submit(const FLASH_ENGINE_JOB_t * pJob)
+{
+	uint32_t putIndex = flash_engine_PutIndex;
+	uint32_t alignment = FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+
+	if( pJob == NULL )
+	{
+		return false;
+	}
+	switch( pJob->type )
+	{
+		case FLASH_ENGINE_JOB_ERASE_SECTOR:
+			alignment = FEATURE_FLS_PF_BLOCK_SECTOR_SIZE;
+			break;
+		case FLASH_ENGINE_JOB_PROGRAM:
+			if( pJob->pData == NULL )
+			{
+				return false;
+			}
+			break;
+		case FLASH_ENGINE_JOB_VERIFY_BLANK:
+			alignment = FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT;
+			break;
+		default:
+			return false;
+	}
+	if( (pJob->byteNum == 0u) || ((pJob->address % alignment) != 0u) || ((pJob->byteNum % alignment) != 0u) )
+	{
+		return false;
+	}
+	if( (pJob->address < flashSSDConfig.PFlashBase) ||
+		((pJob->address + pJob->byteNum) > (flashSSDConfig.PFlashBase + flashSSDConfig.PFlashSize)) )
+	{
+		return false;
+	}
+	if( (putIndex - flash_engine_GetIndex) >= FLASH_ENGINE_QUEUE_SIZE )
+	{
+		// The queue is full
+		return false;
+	}
+
+	flash_engine_Queue[putIndex % FLASH_ENGINE_QUEUE_SIZE] = *pJob;
+	// The job must be in the queue before the interrupt can see it.
+	__asm volatile ("" : : : "memory");
+	flash_engine_PutIndex = putIndex + 1u;
+
+	return true;
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+/*
+ * Start the queued jobs if the queue is not running, and wait in RAM until all of them have finished.
+ * @return:
+ * 		true:	all jobs have succeeded
+ * 		false:	a job has failed, the jobs queued after it have been dropped
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+bool flash_engine_wait(void)
+{
+	if( !flash_engine_Running && (flash_engine_PutIndex != flash_engine_GetIndex) )
+	{
+		// No flash command is running yet, P-Flash code can still be called. Clear the old errors.
+		flash_engine_mask_irq();
+		CLEAR_FTFx_FSTAT_ERROR_BITS;
+		flash_engine_Error = false;
+		flash_engine_Running = true;
+		// The command complete interrupt launches the first job (CCIF is set when idle).
+		FTFx_FCNFG |= FTFx_FCNFG_CCIE_MASK;
+	}
+	while( flash_engine_PutIndex != flash_engine_GetIndex )
+	{
+		// Wait here while the FTFC and UART RX interrupts do the work.
+	}
+	flash_engine_unmask_irq();
+	return !flash_engine_Error;
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+/*
+ * Launch the first command of a job.
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+static void flash_engine_start_job(const FLASH_ENGINE_JOB_t * pJob)
+{
+	uint32_t address = pJob->address - flashSSDConfig.PFlashBase;
+	uint16_t sectionNum = (uint16_t)(pJob->byteNum / FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT);
+
+	flash_engine_Launched = true;
+	if( pJob->type == FLASH_ENGINE_JOB_PROGRAM )
+	{
+		flash_engine_Address = address;
+		flash_engine_RemainingBytes = pJob->byteNum;
+		flash_engine_Offset = 0u;
+		flash_engine_launch_next(pJob);
+		return;
+	}
+
+	flash_engine_RemainingBytes = 0u;
+	FTFx_FCCOB1 = GET_BIT_16_23(address);
+	FTFx_FCCOB2 = GET_BIT_8_15(address);
+	FTFx_FCCOB3 = GET_BIT_0_7(address);
+	if( pJob->type == FLASH_ENGINE_JOB_ERASE_SECTOR )
+	{
+		FTFx_FCCOB0 = FTFx_ERASE_SECTOR;
+	}
+	else
+	{
+		FTFx_FCCOB0 = FTFx_VERIFY_SECTION;
+		FTFx_FCCOB4 = GET_BIT_8_15(sectionNum);
+		FTFx_FCCOB5 = GET_BIT_0_7(sectionNum);
+		FTFx_FCCOB6 = FLASH_VERIFY_MARGIN_LEVEL;
+	}
+
+	// Clear CCIF to launch the command
+	FTFx_FSTAT = FTFx_FSTAT_CCIF_MASK;
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+/*
+ * The current job has finished: call its callback and remove it from the queue.
+ * After a failure the remaining jobs are dropped, their callbacks are called as failed.
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+static void flash_engine_finish_job(bool isSuccessful)
+{
+	const FLASH_ENGINE_JOB_t * pJob = NULL;
+
+	flash_engine_Launched = false;
+	if( !isSuccessful )
+	{
+		flash_engine_Error = true;
+	}
+	do
+	{
+		pJob = &flash_engine_Queue[flash_engine_GetIndex % FLASH_ENGINE_QUEUE_SIZE];
+		if( pJob->callback != NULL )
+		{
+			pJob->callback(isSuccessful, pJob->param);
+		}
+		flash_engine_GetIndex++;
+	} while( !isSuccessful && (flash_engine_GetIndex != flash_engine_PutIndex) );
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+/*
+ * Launch a Program Section command for the 16-bytes aligned middle of the block if possible,
+ * otherwise a Program Phrase command.
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+static void flash_engine_launch_next(const FLASH_ENGINE_JOB_t * pJob)
+{
+#ifdef FLASH_USE_PROGRAM_SECTION
+	if( flash_engine_UseSection &&
+		((flash_engine_Address % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) == 0u) &&
+		(flash_engine_RemainingBytes >= FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT) )
+	{
+		flash_engine_launch_section(pJob);
+		return;
+	}
+#endif
+	flash_engine_launch_phrase(pJob);
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+START_FUNCTION_DEFINITION_RAMSECTION
+static void flash_engine_launch_phrase(const FLASH_ENGINE_JOB_t * pJob)
+{
+	uint8_t i = 0;
+	const uint8_t * pPhrase = pJob->pData + flash_engine_Offset;
+	uint32_t address = flash_engine_Address;
+
+	FTFx_FCCOB0 = FTFx_PROGRAM_PHRASE;
+	FTFx_FCCOB1 = GET_BIT_16_23(address);
+	FTFx_FCCOB2 = GET_BIT_8_15(address);
+	FTFx_FCCOB3 = GET_BIT_0_7(address);
+	for( i = 0; i < FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE; i++ )
+	{
+		*(volatile uint8_t *)(FTFx_BASE + i + 0x08u) = pPhrase[i];
+	}
+
+	flash_engine_Address += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+	flash_engine_Offset += FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+	flash_engine_RemainingBytes -= FEATURE_FLS_PF_BLOCK_WRITE_UNIT_SIZE;
+
+	// Clear CCIF to launch the command
+	FTFx_FSTAT = FTFx_FSTAT_CCIF_MASK;
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+#ifdef FLASH_USE_PROGRAM_SECTION
+/*
+ * Copy the 16-bytes aligned part of the remaining data into FlexRAM and program it by one command.
+ * The section size unit is 128 bits (16 bytes) on S32K144.
+ * Note: memcpy() is in P-Flash, so the copy is done word by word here. The job data may be unaligned,
+ * every word is assembled from its bytes (little-endian).
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+static void flash_engine_launch_section(const FLASH_ENGINE_JOB_t * pJob)
+{
+	uint32_t i = 0;
+	uint32_t address = flash_engine_Address;
+	uint32_t sectionByteNum = flash_engine_RemainingBytes - (flash_engine_RemainingBytes % FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT);
+	uint16_t sectionNum = (uint16_t)(sectionByteNum / FEATURE_FLS_PF_SECTION_CMD_ADDRESS_ALIGMENT);
+	const uint8_t * pSource = pJob->pData + flash_engine_Offset;
+	volatile uint32_t * pSectionBuffer = (volatile uint32_t *)MEMORY_ADDRESS(flashSSDConfig.EERAMBase);
+
+	for( i = 0; i < (sectionByteNum / 4u); i++ )
+	{
+		pSectionBuffer[i] = (uint32_t)pSource[4u * i] | ((uint32_t)pSource[(4u * i) + 1u] << 8) |
+							((uint32_t)pSource[(4u * i) + 2u] << 16) | ((uint32_t)pSource[(4u * i) + 3u] << 24);
+	}
+
+	FTFx_FCCOB0 = FTFx_PROGRAM_SECTION;
+	FTFx_FCCOB1 = GET_BIT_16_23(address);
+	FTFx_FCCOB2 = GET_BIT_8_15(address);
+	FTFx_FCCOB3 = GET_BIT_0_7(address);
+	FTFx_FCCOB4 = GET_BIT_8_15(sectionNum);
+	FTFx_FCCOB5 = GET_BIT_0_7(sectionNum);
+
+	flash_engine_Address += sectionByteNum;
+	flash_engine_Offset += sectionByteNum;
+	flash_engine_RemainingBytes -= sectionByteNum;
+
+	// Clear CCIF to launch the command
+	FTFx_FSTAT = FTFx_FSTAT_CCIF_MASK;
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+#endif
+
+/*
+ * FTFC Command Complete Interrupt
+ * It is entered whenever CCIF is set while CCIE is enabled.
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+void FTFC_IRQHandler(void)
+{
+	const FLASH_ENGINE_JOB_t * pJob = &flash_engine_Queue[flash_engine_GetIndex % FLASH_ENGINE_QUEUE_SIZE];
+
+	if( flash_engine_Launched )
+	{
+		if( (FTFx_FSTAT & FLASH_ENGINE_FSTAT_ERROR_MASK) != 0u )
+		{
+			// The last command has failed (a blank check fails by MGSTAT0). Drop the queued jobs.
+			flash_engine_finish_job(false);
+		}
+		else if( flash_engine_RemainingBytes > 0u )
+		{
+			flash_engine_launch_next(pJob);
+			return;
+		}
+		else
+		{
+			flash_engine_finish_job(true);
+		}
+		pJob = &flash_engine_Queue[flash_engine_GetIndex % FLASH_ENGINE_QUEUE_SIZE];
+	}
+
+	if( flash_engine_GetIndex != flash_engine_PutIndex )
+	{
+		flash_engine_start_job(pJob);
+	}
+	else
+	{
+		// All jobs have finished. Disable the command complete interrupt.
+		FTFx_FCNFG &= (uint8_t)(~FTFx_FCNFG_CCIE_MASK);
+		flash_engine_Running = false;
+	}
+}
+END_FUNCTION_DEFINITION_RAMSECTION
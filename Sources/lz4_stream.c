@@ -0,0 +1,335 @@
+/*
+ * lz4_stream.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "lz4_stream.h"
+#include "crc32.h"
+#include "string.h"
+
+/*
+ * Streaming LZ4 decompressor.
+ *
+ * The compressed image arrives in pieces (the payload of the PC data packets) and is decoded
+ * byte by byte, so a sequence may be split across data packets. The decompressed image is
+ * collected in the output block and handed to the write function whenever the block is full.
+ */
+
+typedef enum
+{
+	LZ4_STREAM_HEADER,			// Collect the header
+	LZ4_STREAM_TOKEN,			// Wait for the next sequence token
+	LZ4_STREAM_LITERAL_LENGTH,	// Collect the extra literal length bytes
+	LZ4_STREAM_LITERALS,		// Output the literal bytes
+	LZ4_STREAM_OFFSET,			// Collect the match offset
+	LZ4_STREAM_MATCH_LENGTH,	// Collect the extra match length bytes
+	LZ4_STREAM_DONE,			// The whole image has been decompressed
+	LZ4_STREAM_ERROR			// The compressed data is corrupted or the output cannot be written
+} LZ4_STREAM_STATE_t;
+
+static LZ4_STREAM_STATE_t lz4_stream_State = LZ4_STREAM_HEADER;
+
+static const uint8_t * lz4_stream_pOutputImage = NULL;
+static uint32_t lz4_stream_OutputImageMaxSize = 0u;
+static LZ4_STREAM_WRITE_t lz4_stream_pWrite = NULL;
+
+// The header or match offset being collected
+static uint8_t lz4_stream_Args[LZ4_STREAM_HEADER_SIZE];
+static uint32_t lz4_stream_ArgsCount = 0u;
+
+static uint32_t lz4_stream_ImageSize = 0u;
+static uint32_t lz4_stream_ImageChecksum = 0u;
+static uint8_t lz4_stream_Token = 0u;
+static uint32_t lz4_stream_LiteralLength = 0u;
+static uint32_t lz4_stream_MatchLength = 0u;
+static uint32_t lz4_stream_MatchOffset = 0u;
+
+// The output block is word aligned for the flash writing
+static uint32_t lz4_stream_OutputBlock[LZ4_STREAM_OUTPUT_BLOCK_SIZE / 4u];
+static uint32_t lz4_stream_OutputCount = 0u;		// The number of bytes in the output block
+static uint32_t lz4_stream_OutputTotal = 0u;		// The number of image bytes output so far
+
+/*
+ * Private Function Prototype
+ */
+static uint32_t lz4_stream_get_u32(const uint8_t * pBytes);
+static bool lz4_stream_output_byte(uint8_t outputByte);
+static bool lz4_stream_decode_header(void);
+static bool lz4_stream_copy_match(void);
+static LZ4_STREAM_STATE_t lz4_stream_end_of_literals(void);
+
+/*
+ * Restart the decompressor for a new download.
+ * @param:
+ * 		pOutputImage: where the written output blocks can be read back (the new firmware area)
+ * 		outputImageMaxSize: the size of the new firmware area
+ * 		pWrite: the function writing the output blocks of the image
+ */
+void lz4_stream_reset(const uint8_t * pOutputImage, uint32_t outputImageMaxSize, LZ4_STREAM_WRITE_t pWrite)
+{
+	lz4_stream_State = LZ4_STREAM_HEADER;
+	lz4_stream_pOutputImage = pOutputImage;
+	lz4_stream_OutputImageMaxSize = outputImageMaxSize;
+	lz4_stream_pWrite = pWrite;
+	lz4_stream_ArgsCount = 0u;
+	lz4_stream_ImageSize = 0u;
+	lz4_stream_ImageChecksum = 0u;
+	lz4_stream_Token = 0u;
+	lz4_stream_LiteralLength = 0u;
+	lz4_stream_MatchLength = 0u;
+	lz4_stream_MatchOffset = 0u;
+	lz4_stream_OutputCount = 0u;
+	lz4_stream_OutputTotal = 0u;
+}
+
+/*
+ * Decompress the next piece of the compressed image.
+ * @param:
+ * 		pData: the compressed bytes
+ * 		byteNum: the number of compressed bytes
+ * @return:
+ * 		true:	the compressed bytes are decoded and the full output blocks are written
+ * 		false:	the compressed data is corrupted or the write has failed
+ */
+bool lz4_stream_input(const uint8_t * pData, uint32_t byteNum)
+{
+	uint32_t i = 0;
+	uint8_t inputByte = 0;
+
+	if( (pData == NULL) || (lz4_stream_pWrite == NULL) || (lz4_stream_pOutputImage == NULL) )
+	{
+		return false;
+	}
+
+	for( i = 0; i < byteNum; i++ )
+	{
+		inputByte = pData[i];
+		switch( lz4_stream_State )
+		{
+			case LZ4_STREAM_HEADER:
+				lz4_stream_Args[lz4_stream_ArgsCount++] = inputByte;
+				if( lz4_stream_ArgsCount == LZ4_STREAM_HEADER_SIZE )
+				{
+					lz4_stream_ArgsCount = 0u;
+					lz4_stream_State = lz4_stream_decode_header() ? LZ4_STREAM_TOKEN : LZ4_STREAM_ERROR;
+				}
+				break;
+
+			case LZ4_STREAM_TOKEN:
+				lz4_stream_Token = inputByte;
+				lz4_stream_LiteralLength = (uint32_t)(inputByte >> 4);
+				lz4_stream_MatchLength = (uint32_t)(inputByte & 0x0Fu) + LZ4_STREAM_MIN_MATCH;
+				if( lz4_stream_LiteralLength == 15u )
+				{
+					lz4_stream_State = LZ4_STREAM_LITERAL_LENGTH;
+				}
+				else if( lz4_stream_LiteralLength > 0u )
+				{
+					lz4_stream_State = LZ4_STREAM_LITERALS;
+				}
+				else
+				{
+					lz4_stream_State = lz4_stream_end_of_literals();
+				}
+				break;
+
+			case LZ4_STREAM_LITERAL_LENGTH:
+				lz4_stream_LiteralLength += inputByte;
+				if( lz4_stream_LiteralLength > lz4_stream_OutputImageMaxSize )
+				{
+					lz4_stream_State = LZ4_STREAM_ERROR;
+				}
+				else if( inputByte != 255u )
+				{
+					lz4_stream_State = LZ4_STREAM_LITERALS;
+				}
+				break;
+
+			case LZ4_STREAM_LITERALS:
+				if( !lz4_stream_output_byte(inputByte) )
+				{
+					lz4_stream_State = LZ4_STREAM_ERROR;
+					break;
+				}
+				lz4_stream_LiteralLength--;
+				if( lz4_stream_LiteralLength == 0u )
+				{
+					lz4_stream_State = lz4_stream_end_of_literals();
+				}
+				break;
+
+			case LZ4_STREAM_OFFSET:
+				lz4_stream_Args[lz4_stream_ArgsCount++] = inputByte;
+				if( lz4_stream_ArgsCount == 2u )
+				{
+					lz4_stream_ArgsCount = 0u;
+					lz4_stream_MatchOffset = (uint32_t)lz4_stream_Args[0] | ((uint32_t)lz4_stream_Args[1] << 8);
+					if( (lz4_stream_Token & 0x0Fu) == 15u )
+					{
+						lz4_stream_State = LZ4_STREAM_MATCH_LENGTH;
+					}
+					else
+					{
+						lz4_stream_State = lz4_stream_copy_match() ? LZ4_STREAM_TOKEN : LZ4_STREAM_ERROR;
+					}
+				}
+				break;
+
+			case LZ4_STREAM_MATCH_LENGTH:
+				lz4_stream_MatchLength += inputByte;
+				if( lz4_stream_MatchLength > lz4_stream_OutputImageMaxSize )
+				{
+					lz4_stream_State = LZ4_STREAM_ERROR;
+				}
+				else if( inputByte != 255u )
+				{
+					lz4_stream_State = lz4_stream_copy_match() ? LZ4_STREAM_TOKEN : LZ4_STREAM_ERROR;
+				}
+				break;
+
+			case LZ4_STREAM_DONE:
+			default:
+				// No compressed byte is allowed after the end of the image.
+				lz4_stream_State = LZ4_STREAM_ERROR;
+				break;
+		}
+
+		if( lz4_stream_State == LZ4_STREAM_ERROR )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Write the last output block after the whole compressed image has been received.
+ * The last block is padded with 0xFF to the flash phrase size.
+ * @return:
+ * 		true if the image is complete and its checksum matches the header
+ */
+bool lz4_stream_finish(void)
+{
+	uint8_t * pOutputBlock = (uint8_t *)lz4_stream_OutputBlock;
+
+	if( lz4_stream_State != LZ4_STREAM_DONE )
+	{
+		return false;
+	}
+	crc32_update(pOutputBlock, lz4_stream_OutputCount);
+	if( crc32_result() != lz4_stream_ImageChecksum )
+	{
+		return false;
+	}
+	if( lz4_stream_OutputCount > 0u )
+	{
+		while( (lz4_stream_OutputCount % 8u) != 0u )
+		{
+			pOutputBlock[lz4_stream_OutputCount++] = 0xFFu;
+		}
+		if( !lz4_stream_pWrite(pOutputBlock, lz4_stream_OutputCount) )
+		{
+			return false;
+		}
+		lz4_stream_OutputCount = 0u;
+	}
+	return true;
+}
+
+static uint32_t lz4_stream_get_u32(const uint8_t * pBytes)
+{
+	return ((uint32_t)pBytes[0]) |
+		   ((uint32_t)pBytes[1] << 8) |
+		   ((uint32_t)pBytes[2] << 16) |
+		   ((uint32_t)pBytes[3] << 24);
+}
+
+/*
+ * Append one byte of the image to the output block, write the block when it is full.
+ */
+static bool lz4_stream_output_byte(uint8_t outputByte)
+{
+	uint8_t * pOutputBlock = (uint8_t *)lz4_stream_OutputBlock;
+
+	if( lz4_stream_OutputTotal >= lz4_stream_ImageSize )
+	{
+		// More output than announced in the header
+		return false;
+	}
+	pOutputBlock[lz4_stream_OutputCount++] = outputByte;
+	lz4_stream_OutputTotal++;
+
+	if( lz4_stream_OutputCount == LZ4_STREAM_OUTPUT_BLOCK_SIZE )
+	{
+		lz4_stream_OutputCount = 0u;
+		crc32_update(pOutputBlock, LZ4_STREAM_OUTPUT_BLOCK_SIZE);
+		return lz4_stream_pWrite(pOutputBlock, LZ4_STREAM_OUTPUT_BLOCK_SIZE);
+	}
+	return true;
+}
+
+static bool lz4_stream_decode_header(void)
+{
+	if( (lz4_stream_Args[0] != (uint8_t)LZ4_STREAM_MAGIC_0) ||
+		(lz4_stream_Args[1] != (uint8_t)LZ4_STREAM_MAGIC_1) ||
+		(lz4_stream_Args[2] != LZ4_STREAM_VERSION) )
+	{
+		return false;
+	}
+	lz4_stream_ImageSize = lz4_stream_get_u32(&lz4_stream_Args[4]);
+	lz4_stream_ImageChecksum = lz4_stream_get_u32(&lz4_stream_Args[8]);
+	// Start the CRC of the decompressed image
+	crc32_start();
+	return (lz4_stream_ImageSize <= lz4_stream_OutputImageMaxSize);
+}
+
+/*
+ * The last sequence of the image has no match, it ends after its literals.
+ */
+static LZ4_STREAM_STATE_t lz4_stream_end_of_literals(void)
+{
+	if( lz4_stream_OutputTotal == lz4_stream_ImageSize )
+	{
+		return LZ4_STREAM_DONE;
+	}
+	return LZ4_STREAM_OFFSET;
+}
+
+/*
+ * Output a match from the already decompressed image.
+ * The older bytes are read back from the written output, the newer ones from the output block.
+ */
+static bool lz4_stream_copy_match(void)
+{
+	const uint8_t * pOutputBlock = (const uint8_t *)lz4_stream_OutputBlock;
+	uint32_t writtenTotal = 0;
+	uint32_t position = 0;
+	uint32_t i = 0;
+
+	if( (lz4_stream_MatchOffset == 0u) || (lz4_stream_MatchOffset > lz4_stream_OutputTotal) )
+	{
+		return false;
+	}
+	for( i = 0; i < lz4_stream_MatchLength; i++ )
+	{
+		// Both change when the output block is written, so recalculate them for every byte.
+		writtenTotal = lz4_stream_OutputTotal - lz4_stream_OutputCount;
+		position = lz4_stream_OutputTotal - lz4_stream_MatchOffset;
+		if( position >= writtenTotal )
+		{
+			if( !lz4_stream_output_byte(pOutputBlock[position - writtenTotal]) )
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if( !lz4_stream_output_byte(lz4_stream_pOutputImage[position]) )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
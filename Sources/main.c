@@ -30,6 +30,7 @@
 #include "stdio.h"
 #include "string.h"
 #include "system_config.h"
+#include "trace.h"
 
 #define LED_OFF				PINS_DRV_ClearPins(PTE, 1<<8)
 #define LED_ON				PINS_DRV_SetPins(PTE, 1<<8)
@@ -61,6 +62,7 @@ void timer_interrupt_off(void);
 int main(void)
 {
   /* Write your local variable definition here */
+    bool isPowerLost = false;
 
   /*** Processor Expert internal initialization. DON'T REMOVE THIS CODE!!! ***/
   #ifdef PEX_RTOS_INIT
@@ -83,8 +85,27 @@ int main(void)
     	return exit_code;
     }
 
+    /*
+     * The RAM kept over the warm resets (the trace ring, the fast boot count) is undefined after a power loss.
+     * The sticky reset status tells a power loss since the last boot, also when the bootloader is
+     * restarted by auto_flash_reset(), which is a jump and keeps the reset status.
+     */
+    isPowerLost = ((RCM->SSRS & (RCM_SSRS_SPOR_MASK | RCM_SSRS_SLVD_MASK)) != 0u);
+    // Write 1 to clear the sticky flags
+    RCM->SSRS = RCM_SSRS_SPOR_MASK | RCM_SSRS_SLVD_MASK;
+
+    // Start the phase latency trace of this boot
+    trace_init(isPowerLost);
+
 //    LPUART_DRV_SendDataPolling(INST_LPUART0, test_text, sizeof(test_text));
 
+#ifdef FIRMWARE_FAST_BOOT
+    /*
+     * If the old firmware has been verified recently, this function will not return.
+     */
+    firmware_fast_boot(isPowerLost);
+#endif
+
     flash_init();
 
     /*
@@ -7,12 +7,24 @@
 
 #include "pc_communication.h"
 #include "bootloader.h"
+#ifdef PC2UART_FRAME_CRC16
+#include "crc16.h"
+#endif
+#include "delta_patch.h"
+#include "lz4_stream.h"
+#include "trace.h"
 #include "Cpu.h"
 #include "stdio.h"
 #include "string.h"
 #include "system_config.h"
 
-#define UART_RX_RING_BUFFER_SIZE	256
+// The ring buffer must hold a full window of sequenced data packets.
+#define UART_RX_RING_BUFFER_SIZE	(PC2UART_WINDOW_SIZE * 256u)	// A full window of the largest data packets
+#define UART_RX_RING_BUFFER_MASK	(UART_RX_RING_BUFFER_SIZE - 1u)
+
+#if ((UART_RX_RING_BUFFER_SIZE & UART_RX_RING_BUFFER_MASK) != 0u)
+#error "UART_RX_RING_BUFFER_SIZE must be a power of 2"
+#endif
 
 // Acknowledge message
 //#define ACKNOWLEDGE_MSG 	"Send acknowledge to PC! Checksum OK\r\n"
@@ -21,6 +33,10 @@
 // MCU to PC Acknowledge Data Packet Type
 #define ACK_CODE	0x10u	// Acknowledge response data packet type
 #define ERR_CODE	0x11u	// No Acknowledge response data packet type
+#define ACK_SEQ_CODE	0x12u	// Sliding window cumulative acknowledge response data packet type
+#define ERR_SEQ_CODE	0x13u	// Sliding window no acknowledge response data packet type
+#define RESUME_CODE		0x14u	// Resume point response data packet type
+#define TRACE_CODE		0x15u	// Trace dump response data packet type
 
 #define LED_OFF		PINS_DRV_ClearPins(PTE, 1<<8)
 #define LED_ON		PINS_DRV_SetPins(PTE, 1<<8)
@@ -30,11 +46,19 @@
 const uint8_t WriteFlashMemory = 0x01u;			// Write new program to MCU flash memory.
 const uint8_t ResetOK		= 0x02u;			// Reset the MCU and set the firmware update flag after writing firmware to flash is successful.
 const uint8_t ResetNotOK	= 0x03u;			// Reset the MCU and clear the firmware update flag after writing firmware to flash is unsuccessful.
+const uint8_t WriteFlashMemorySequenced = 0x04u;	// Write new program to MCU flash memory in sliding window mode.
+const uint8_t SetBaudRate	= 0x05u;			// Switch the UART to the baud rate proposed by the PC.
+const uint8_t WriteDeltaPatchSequenced = 0x06u;	// Write a delta patch against the installed firmware in sliding window mode.
+const uint8_t WriteCompressedSequenced = 0x07u;	// Write an LZ4 compressed firmware in sliding window mode.
+const uint8_t QueryResumePoint = 0x08u;			// Continue the download of the image with the given id where it was interrupted.
+const uint8_t DumpTrace		= 0x09u;			// Read the phase latency trace.
 
 // The error info in no acknowledge response data packet
 const uint8_t 	WriteFlashMemoryError 	= 120u;		// The writing of flash program memory has failed
 const uint8_t	ChecksumError       	= 121u;
 const uint8_t	TimeoutError 			= 122u;
+const uint8_t	SequenceError			= 123u;		// The sliding window data packet is out of sequence
+const uint8_t	BaudRateError			= 124u;		// The proposed baud rate cannot be generated accurately
 
 DATA_PACKET_t rx_data_packet;
 
@@ -42,12 +66,80 @@ uint8_t uart_rx_buffer[UART_RX_RING_BUFFER_SIZE] = {0};
 FIFO_RING_BUFFER_t uart_rx_ring_buffer = {
 			.putByteIndex = 0,
 			.getByteIndex = 0,
-			.usedBytesCount = 0,
-			.size = sizeof(uart_rx_buffer),
+			.overrunCount = 0,
+			.highWaterMark = 0,
 			.pRingBuffer = uart_rx_buffer
 			};
 
+#ifdef UART_RX_USE_DMA
+// eDMA channel that copies every received byte from LPUART0 into the RX ring buffer
+#define UART_RX_DMA_CHANNEL		EDMA_CHN0_NUMBER
+
+const edma_channel_config_t uart_rx_dma_channel_config = {
+	.channelPriority = EDMA_CHN_DEFAULT_PRIORITY,
+	.virtChnConfig = UART_RX_DMA_CHANNEL,
+	.source = EDMA_REQ_LPUART0_RX,
+	.callback = NULL,
+	.callbackParam = NULL
+};
+
+/*
+ * One byte per minor loop, one major loop = the whole ring buffer.
+ * After the major loop the destination address wraps back to the buffer start.
+ */
+edma_loop_transfer_config_t uart_rx_dma_loop_config = {
+	.majorLoopIterationCount = UART_RX_RING_BUFFER_SIZE,
+	.srcOffsetEnable = false,
+	.dstOffsetEnable = false,
+	.minorLoopOffset = 0,
+	.minorLoopChnLinkEnable = false,
+	.minorLoopChnLinkNumber = 0u,
+	.majorLoopChnLinkEnable = false,
+	.majorLoopChnLinkNumber = 0u
+};
+
+edma_transfer_config_t uart_rx_dma_transfer_config = {
+	.srcAddr = 0u,					// LPUART0 DATA register, set at run time
+	.destAddr = 0u,					// RX ring buffer, set at run time
+	.srcTransferSize = EDMA_TRANSFER_SIZE_1B,
+	.destTransferSize = EDMA_TRANSFER_SIZE_1B,
+	.srcOffset = 0,
+	.destOffset = 1,
+	.srcLastAddrAdjust = 0,
+	.destLastAddrAdjust = -(int32_t)UART_RX_RING_BUFFER_SIZE,
+	.srcModulo = EDMA_MODULO_OFF,
+	.destModulo = EDMA_MODULO_OFF,
+	.minorByteTransferCount = 1u,
+	.scatterGatherEnable = false,
+	.scatterGatherNextDescAddr = 0u,
+	.interruptEnable = false,
+	.loopTransferConfig = &uart_rx_dma_loop_config
+};
+#endif
+
 UART_RECEIVER_STATE_t PC2UART_ReceiverStatus = READY_FOR_DATA_RX;
+// The number of data payload and check bytes of the current data packet that are copied out of the ring buffer.
+static uint32_t rxPayloadByteCount = 0u;
+/*
+ * The data payload of the received data packet (zero-copy).
+ * It points into the ring buffer, where the payload and checksum are held until the next data packet is parsed.
+ * Only a payload that wraps around the ring buffer end is copied into rx_data_packet.item.raw_data.
+ */
+static const uint8_t * pRxPayload = NULL;
+static uint32_t rxHeldByteNum = 0u;			// The bytes of the received data packet held in the ring buffer
+#ifdef PC2UART_FRAMING_COBS
+/*
+ * COBS frame decoder status.
+ * rxFrameByteCount:	The number of decoded bytes of the current frame in rx_data_packet.buffer.
+ * cobsBlockCode:		The code byte of the current block, a block shorter than 0xFF is followed by a zero.
+ * cobsBlockByteNum:	The number of data bytes of the current block still to be decoded.
+ * isRxFrameDropped:	The current frame is not a data packet, skip it up to its delimiter.
+ */
+static uint32_t rxFrameByteCount = 0u;
+static uint8_t cobsBlockCode = 0u;
+static uint8_t cobsBlockByteNum = 0u;
+static bool isRxFrameDropped = false;
+#endif
 
 // The flag to indicate if the firmware is being downloaded.
 bool isFirmwareDownloading = false;
@@ -61,25 +153,94 @@ uint16_t countDownloadTime = 0;
 const uint8_t DataPacketHeader = 0x55u;
 const uint8_t DataPacketType_PutData = 0x0Bu;
 const uint8_t DataPacketSize = 69u; // 0x45u  The
+const uint8_t DataPacketOverhead = 4u + DATA_PACKET_CHECK_LENGTH;	// header, type, size, command and checksum (or CRC-16)
+const uint8_t DataPacketOverheadSequenced = 5u + DATA_PACKET_CHECK_LENGTH;	// The sequence number is prepended to the program data
+
+/*
+ * Sliding window receiver status.
+ * expectedSequenceNumber:	The sequence number of the next data packet to be written to flash.
+ * unacknowledgedCount:		The number of data packets written to flash since the last cumulative acknowledge.
+ * isWindowNackSent:		A no acknowledge has been sent for the current gap, suppress further ones until the gap is closed.
+ */
+static uint8_t expectedSequenceNumber = 0u;
+static uint8_t unacknowledgedCount = 0u;
+static bool isWindowNackSent = false;
+
+// The data command of the current download. One download carries one kind of data only (0 = no data yet).
+static uint8_t downloadDataCommand = 0u;
+// The download has been started by QueryResumePoint, only a plain image can be resumed.
+static bool isDownloadResumable = false;
+
+/*
+ * Baud rate negotiation status.
+ * previousBaudRate:			The baud rate to fall back to if the new baud rate is not confirmed.
+ * isBaudRateConfirmPending:	The baud rate has been switched and waits for the first data packet.
+ * baudRateSwitchTime:			The download time when the baud rate was switched.
+ */
+static uint32_t previousBaudRate = 0u;
+static bool isBaudRateConfirmPending = false;
+static uint16_t baudRateSwitchTime = 0u;
 
 extern void timer_stop(void);
+extern void LPUART_DRV_IRQHandler(uint32_t instance);
 
 // Function declaration for internal use
 bool isDownloadTimeout( void );
-bool isRxDataPacketCorrect( DATA_PACKET_t * pDataPacket );
-bool checkDataPacket( DATA_PACKET_t * pDataPacket );
-void printDataPacket( DATA_PACKET_t * pDataPacket );
+bool PC2UART_ParseDataPacket( void );
+#ifdef PC2UART_FRAMING_COBS
+bool PC2UART_ParseCobsFrame( void );
+bool isRxCobsFrameDataPacket( void );
+void PC2UART_DropCobsDelimiters( void );
+#endif
+bool isRxDataPacketCommand( uint8_t command );
+bool isRxDataPacketCorrect( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload );
+bool checkDataPacket( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload );
+bool isProgramDataSizeValid( uint32_t programDataSize );
+void printDataPacket( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload );
 void calculateChecksum( DATA_PACKET_t * pDataPacket );
 
 void SendAcknowledge(void);
 void SendNoAcknowledge(uint8_t errorInfo);
+void SendWindowAcknowledge(void);
+void SendWindowNoAcknowledge(uint8_t errorInfo);
+void SendResumePoint(uint32_t resumeOffset);
+void SendTrace(uint16_t firstIndex);
+
+bool PC2UART_NegotiateBaudRate(uint32_t desiredBaudRate);
+bool PC2UART_ConfirmBaudRate(bool isFirstPacketCorrect);
+void PC2UART_ApplyBaudRate(uint32_t baudRate);
+
+bool PC2UART_WriteData(uint8_t command, const uint8_t * pData, uint32_t byteNum);
+bool PC2UART_FinishData(void);
+void PC2UART_ResumeDownload(uint32_t imageId);
 
 bool FifoRingBuffer_IsEmpty(void);
-bool FifoRingBuffer_IsFull(void);
-bool FifoRingBuffer_PutByte(uint8_t InputByte);
 bool FifoRingBuffer_GetByte(uint8_t * pOutputByte);
+uint32_t FifoRingBuffer_GetSpan(const uint8_t ** ppData);
+void FifoRingBuffer_Commit(uint32_t byteNum);
+#ifdef UART_RX_USE_DMA
+void UartRxDma_init(void);
+void FifoRingBuffer_UpdateFromDma(void);
+#endif
+void FifoRingBuffer_Flush(void);
 void handleRxByte(void *driverState, uart_event_t event, void *userData);
 
+/*
+ * The UART RX path is placed in RAM, so the received bytes are still served
+ * while the flash write engine is programming the P-Flash.
+ */
+START_FUNCTION_DECLARATION_RAMSECTION
+bool FifoRingBuffer_IsFull(void)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+bool FifoRingBuffer_PutByte(uint8_t InputByte)
+END_FUNCTION_DECLARATION_RAMSECTION
+
+START_FUNCTION_DECLARATION_RAMSECTION
+void PC2UART_RxTx_IRQHandler(void)
+END_FUNCTION_DECLARATION_RAMSECTION
+
 /*
  * Initialize the PC to s32k144 MCU UART communication
  */
@@ -91,6 +252,20 @@ void PC2UART_communication_init(void)
 //    uint8_t lpuart0_interrupt_priority = 0;
 //    lpuart0_interrupt_priority = INT_SYS_GetPriority(LPUART0_RxTx_IRQn);
     LPUART_DRV_InstallRxCallback(INST_LPUART0, handleRxByte, NULL);
+    // Replace the SDK LPUART0 handler by the RAM-resident handler for byte by byte reception.
+    INT_SYS_InstallHandler(LPUART0_RxTx_IRQn, PC2UART_RxTx_IRQHandler, (isr_t *)0);
+#ifdef UART_RX_USE_DMA
+    UartRxDma_init();
+#elif defined(PC2UART_FRAMING_COBS)
+    /*
+     * Interrupt on an idle line, counted from the stop bit of the last character.
+     * The idle line configuration may only be changed while the transmitter and receiver are disabled.
+     */
+    LPUART0->CTRL &= ~(LPUART_CTRL_TE_MASK | LPUART_CTRL_RE_MASK);
+    LPUART0->CTRL = (LPUART0->CTRL & (~LPUART_CTRL_IDLECFG_MASK)) | LPUART_CTRL_IDLECFG(PC2UART_IDLE_LINE_CONFIG) |
+    				LPUART_CTRL_ILT_MASK | LPUART_CTRL_ILIE_MASK;
+    LPUART0->CTRL |= (LPUART_CTRL_TE_MASK | LPUART_CTRL_RE_MASK);
+#endif
 }
 
 /*
@@ -99,10 +274,9 @@ void PC2UART_communication_init(void)
 void PC2UART_receiver_run(void)
 {
 //	static status_t uart_rx_status = 0;
-	static uint32_t byteCount = 0;						// Count the number of data bytes that are read out of the ring buffer.
 	static bool isWriteSuccessful = false;				// Return value to indicate if the write operation is successful.
 	static bool isDataPacketCorrect = false;			// Indicate if the received data packet is expected data packet.
-	uint8_t rxByte = 0;
+	bool isDownloadComplete = true;						// Indicate if the delta patch or compressed image (if any) has rebuilt the whole new firmware.
 
 	// Check download timeout
 	if( isDownloadTimeout() )
@@ -111,11 +285,19 @@ void PC2UART_receiver_run(void)
 		PC2UART_ReceiverStatus = READY_FOR_DATA_RX;
 	}
 
+	// Fall back to the old baud rate if no data packet arrives at the new baud rate.
+	if( isBaudRateConfirmPending && ((uint16_t)(countDownloadTime - baudRateSwitchTime) > PC2UART_BAUD_RATE_CONFIRM_TIME) )
+	{
+		PC2UART_ConfirmBaudRate(false);
+		PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+	}
+
 	switch (PC2UART_ReceiverStatus)
 	{
 		case READY_FOR_DATA_RX:
 			// Make sure LED off.
 			LED_OFF;
+#ifndef UART_RX_USE_DMA
 			if( lpuart0_State.isRxBusy )
 			{
 				// There is an active data reception. Abort reception and WAIT!
@@ -123,205 +305,140 @@ void PC2UART_receiver_run(void)
 				PC2UART_ReceiverStatus = READY_FOR_DATA_RX;
 			}
 			else
+#endif
 			{
 				// UART RX module is not busy now. START data reception!
 				PC2UART_ReceiverStatus = INITIATE_DATA_RX;
 				/*
-				 * If the previous download process is aborted, download the firmware and rewrite it to flash again.
+				 * If the previous download process is aborted, download the firmware and rewrite it to flash again,
+				 * unless the PC continues it from the resume point kept in EEPROM (QueryResumePoint).
 				 */
-				flash_auto_write_64bytes_reset();
+				flash_auto_write_reset();
+				expectedSequenceNumber = 0u;
+				unacknowledgedCount = 0u;
+				isWindowNackSent = false;
+				downloadDataCommand = 0u;
+				isDownloadResumable = false;
+				// A new download always starts at the default baud rate.
+				isBaudRateConfirmPending = false;
+				PC2UART_ApplyBaudRate(lpuart0_InitConfig0.baudRate);
 			}
 			break;
 
 		case INITIATE_DATA_RX:
+#ifdef UART_RX_USE_DMA
+			// The eDMA channel runs continuously since PC2UART_communication_init(), no RX interrupt is needed.
+#else
 			// Call non-blocking receive function to initiate the data reception process.
 			LPUART_DRV_ReceiveData(INST_LPUART0, NULL, 0u);		// Enable RX Interrupt
+#endif
 			// Immediately return after the non-blocking receive data function is called.
 			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 			break;
 
 		case FIND_RX_DATA_PACKET_HEADER:
-			if( isFirmwareDownloading )
+		case CHECK_RX_DATA_PACKET_TYPE:
+		case CHECK_RX_DATA_PACKET_SIZE:
+		case CHECK_RX_DATA_PACKET_CMD:
+		case EXTRACT_RX_DATA_PACKET:
+			// Drain the ring buffer until a whole data packet has been received.
+#ifdef PC2UART_FRAMING_COBS
+			if( !PC2UART_ParseCobsFrame() )
+#else
+			if( !PC2UART_ParseDataPacket() )
+#endif
 			{
-				LED_OFF;
+				break;
 			}
-			if( FifoRingBuffer_IsEmpty() )
+			PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET;
+			/* no break: check the data packet in the same call */
+
+		case CHECK_RX_DATA_PACKET:
+			// Check checksum actually.
+			if( checkDataPacket(&rx_data_packet, pRxPayload) )
 			{
-				// No rx byte in the FIFO Ring Buffer.
-				// Wait until there is at least one rx byte.
-				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				isDataPacketCorrect = true;
 			}
 			else
 			{
-				// FIFO Ring Buffer has at least one byte.
-				FifoRingBuffer_GetByte(&rxByte);
-				// Find rx data packet header
-				if( rxByte == DataPacketHeader )
-				{
-					// The data packet header is found. Next to check data packet type
-					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_TYPE;
-					// Clear the rx data packet.
-					memset(rx_data_packet.buffer, 0u, sizeof(rx_data_packet.buffer));
-					rx_data_packet.item.header = rxByte;
-					// Turn LED on to indicate the firmware download in progress.
-					LED_ON;
-				}
-				else
-				{
-					// The data packet header is not found. Continue to find the header.
-					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
-				}
+				isDataPacketCorrect = false;
 			}
-			break;
-
-		case CHECK_RX_DATA_PACKET_TYPE:
-			if( FifoRingBuffer_IsEmpty() )
+#ifdef DEBUG_FROM_RAM
+//			printDataPacket(&rx_data_packet, pRxPayload);
+#endif
+			// The first data packet after a baud rate switch decides if the new baud rate is kept.
+			if( isBaudRateConfirmPending && (!PC2UART_ConfirmBaudRate(isDataPacketCorrect)) )
 			{
-				// No rx byte in the FIFO Ring Buffer.
-				// Wait until there is at least one rx byte.
-				PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_TYPE;
+				// Back at the old baud rate, the PC sends the data packet again.
+				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				break;
 			}
-			else
+			// Check command to execute
+			if( rx_data_packet.item.command == SetBaudRate )
 			{
-				// FIFO Ring Buffer has at least one byte.
-				FifoRingBuffer_GetByte(&rxByte);
-				// Check rx data packet type.
-				if( rxByte == DataPacketType_PutData )
+				if( isDataPacketCorrect && (rx_data_packet.item.size == (DataPacketOverhead + 4u)) )
 				{
-					// The data packet type is correct. Next to check data packet size.
-					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_SIZE;
-					rx_data_packet.item.type = rxByte;
+					PC2UART_NegotiateBaudRate( (uint32_t)pRxPayload[0] |
+											  ((uint32_t)pRxPayload[1] << 8) |
+											  ((uint32_t)pRxPayload[2] << 16) |
+											  ((uint32_t)pRxPayload[3] << 24) );
 				}
 				else
 				{
-					// The data packet type is wrong. Restart to find the header.
-					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+					SendNoAcknowledge(ChecksumError);
 				}
+				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 			}
-			break;
-
-		case CHECK_RX_DATA_PACKET_SIZE:
-			if( FifoRingBuffer_IsEmpty() )
-			{
-				// No RX byte in the FIFO Ring Buffer.
-				// Wait until there is at least one RX byte.
-				PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_SIZE;
-			}
-			else
+			else if( rx_data_packet.item.command == QueryResumePoint )
 			{
-				// FIFO Ring Buffer has at least one byte.
-				FifoRingBuffer_GetByte(&rxByte);
-				// Check RX data packet size.
-				if( (rxByte >= 5u) && (rxByte <= 255u) )
+				if( isDataPacketCorrect && (rx_data_packet.item.size == (DataPacketOverhead + 4u)) )
 				{
-					// The data packet size is correct. Next to receive command.
-					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_CMD;
-					rx_data_packet.item.size = rxByte;
+					PC2UART_ResumeDownload( (uint32_t)pRxPayload[0] |
+										   ((uint32_t)pRxPayload[1] << 8) |
+										   ((uint32_t)pRxPayload[2] << 16) |
+										   ((uint32_t)pRxPayload[3] << 24) );
 				}
 				else
 				{
-					// The data packet size is wrong. Restart to find the header.
-					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+					SendNoAcknowledge(ChecksumError);
 				}
+				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 			}
-			break;
-
-		case CHECK_RX_DATA_PACKET_CMD:
-			if( FifoRingBuffer_IsEmpty() )
-			{
-				// No RX byte in the FIFO Ring Buffer.
-				// Wait until there is at least one RX byte.
-				PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_CMD;
-			}
-			else
+			else if( rx_data_packet.item.command == DumpTrace )
 			{
-				// FIFO Ring Buffer has at least one byte.
-				FifoRingBuffer_GetByte(&rxByte);
-				// Check RX data packet command.
-				if( (rxByte == WriteFlashMemory) ||
-					(rxByte == ResetOK) ||
-					(rxByte == ResetNotOK) )
+				if( isDataPacketCorrect && (rx_data_packet.item.size == (DataPacketOverhead + 2u)) )
 				{
-					// The data packet command is what we expect. Next to receive data payload and checksum.
-					PC2UART_ReceiverStatus = EXTRACT_RX_DATA_PACKET;
-					rx_data_packet.item.command = rxByte;
-					// Set the flag to indicate that the firmware is being downloaded.
-					if(isFirmwareDownloading == false)
-					{
-						isFirmwareDownloading = true;
-						countDownloadTime = 0;
-					}
+					SendTrace( (uint16_t)pRxPayload[0] |
+							  ((uint16_t)pRxPayload[1] << 8) );
 				}
 				else
 				{
-					// The data packet command is not what we expect. Restart to find the header.
-					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+					SendNoAcknowledge(ChecksumError);
 				}
+				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 			}
-			break;
-
-		case EXTRACT_RX_DATA_PACKET:
-			if( FifoRingBuffer_IsEmpty() && (byteCount < (rx_data_packet.item.size - 4u)) )		// Now ignore the header, type, size and command
-			{
-				PC2UART_ReceiverStatus = EXTRACT_RX_DATA_PACKET;
-			}
-			else
+			else if( rx_data_packet.item.command == WriteFlashMemory )
 			{
-				if( rx_data_packet.item.size == 5u )
+				if( isDataPacketCorrect )
 				{
-					// Directly read checksum
-					FifoRingBuffer_GetByte(&rxByte);
-					rx_data_packet.item.checksum = rxByte;
-					byteCount = 0;
-					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET;
+					PC2UART_ReceiverStatus = WRITE_RPOGRAM_TO_FLASH;
 				}
 				else
 				{
-					if( (byteCount >= 0u) && (byteCount < (rx_data_packet.item.size - 5u)) )  // ignore the header, type, size, command
-					{
-						// Read data payload
-						FifoRingBuffer_GetByte(&rxByte);
-						rx_data_packet.item.raw_data[byteCount++] = rxByte;
-						PC2UART_ReceiverStatus = EXTRACT_RX_DATA_PACKET;
-					}
-					else if( byteCount == (rx_data_packet.item.size - 5u) )
-					{
-						// Read checksum
-						FifoRingBuffer_GetByte(&rxByte);
-						rx_data_packet.item.checksum = rxByte;
-						byteCount = 0;
-						PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET;
-					}
-					else
-					{
-						// byteCount error and restart to find the header
-						PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
-					}
+					/*
+					 * A corrupted data packet is never written into flash memory.
+					 * Nothing has been written, so the PC can send it again.
+					 */
+					SendNoAcknowledge(ChecksumError);
+					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 				}
 			}
-			break;
-
-		case CHECK_RX_DATA_PACKET:
-			// Check checksum actually.
-			if( checkDataPacket(&rx_data_packet) )
-			{
-				isDataPacketCorrect = true;
-			}
-			else
-			{
-				isDataPacketCorrect = false;
-			}
-#ifdef DEBUG_FROM_RAM
-//			printDataPacket(&rx_data_packet);
-#endif
-			// Check command to execute
-			if( rx_data_packet.item.command == WriteFlashMemory )
+			else if( (rx_data_packet.item.command == WriteFlashMemorySequenced) ||
+					 (rx_data_packet.item.command == WriteDeltaPatchSequenced) ||
+					 (rx_data_packet.item.command == WriteCompressedSequenced) )
 			{
-				/*
-				 * No matter if the data packet is correct or not,
-				 * we always write it into flash memory.
-				 */
-				PC2UART_ReceiverStatus = WRITE_RPOGRAM_TO_FLASH;
+				// Only a correct data packet in sequence is written into flash memory.
+				PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_SEQUENCE;
 			}
 			else if( (rx_data_packet.item.command == ResetOK) ||
 					 (rx_data_packet.item.command == ResetNotOK) )
@@ -343,13 +460,17 @@ void PC2UART_receiver_run(void)
 #ifdef TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE
 			isWriteSuccessful = true;
 #else
-			isWriteSuccessful = flash_auto_write_64bytes();
+			isWriteSuccessful = false;
+			if( isProgramDataSizeValid(rx_data_packet.item.size - DataPacketOverhead) )
+			{
+				isWriteSuccessful = PC2UART_WriteData(rx_data_packet.item.command, pRxPayload, rx_data_packet.item.size - DataPacketOverhead);
+			}
 #endif
 			PC2UART_ReceiverStatus = SEND_ACKNOWLEDGE_MSG;
 			break;
 
 		case SEND_ACKNOWLEDGE_MSG:
-			if( isDataPacketCorrect && isWriteSuccessful )
+			if( isWriteSuccessful )
 			{
 				/*
 				 * The data packet checksum is correct and
@@ -362,20 +483,6 @@ void PC2UART_receiver_run(void)
 //				LPUART_DRV_SendDataPolling(INST_LPUART0, (uint8_t *)ACKNOWLEDGE_MSG, strlen(ACKNOWLEDGE_MSG));
 				SendAcknowledge();
 			}
-			else if( (!isDataPacketCorrect) && isWriteSuccessful )
-			{
-				/*
-				 * The data packet checksum is not correct.
-				 * But, the data packet is successfully written into the flash memory.
-				 * Then, send checksum error acknowledge.
-				 */
-#ifdef DEBUG_FROM_RAM
-//				printf("Error: rx data packet\r\n");
-//				LPUART_DRV_SendDataPolling(INST_LPUART0, (uint8_t *)ERROR_MSG, strlen(ERROR_MSG));
-//				calculateChecksum(&rx_data_packet);
-#endif
-				SendNoAcknowledge(ChecksumError);
-			}
 			else
 			{
 				/*
@@ -391,9 +498,87 @@ void PC2UART_receiver_run(void)
 			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
 			break;
 
+		case CHECK_RX_DATA_PACKET_SEQUENCE:
+			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+			if( (!isDataPacketCorrect) ||
+				(rx_data_packet.item.size <= DataPacketOverheadSequenced) ||
+				((rx_data_packet.item.command == WriteFlashMemorySequenced) &&
+				 (!isProgramDataSizeValid(rx_data_packet.item.size - DataPacketOverheadSequenced))) )
+			{
+				/*
+				 * The data packet is corrupted and its sequence number cannot be trusted.
+				 * Ask the PC to go back to the expected sequence number.
+				 */
+				if( !isWindowNackSent )
+				{
+					SendWindowNoAcknowledge(ChecksumError);
+					isWindowNackSent = true;
+				}
+			}
+			else if( pRxPayload[0] == expectedSequenceNumber )
+			{
+				// The data packet is the next one in sequence. Write it into flash memory.
+				PC2UART_ReceiverStatus = WRITE_SEQUENCED_PROGRAM_TO_FLASH;
+			}
+			else if( (uint8_t)(expectedSequenceNumber - pRxPayload[0]) <= PC2UART_WINDOW_SIZE )
+			{
+				/*
+				 * The data packet has already been written (a retransmission after a go back).
+				 * Do not write it again, just repeat the cumulative acknowledge.
+				 */
+				if( !isWindowNackSent )
+				{
+					SendWindowAcknowledge();
+				}
+			}
+			else
+			{
+				// At least one data packet before this one is lost.
+				if( !isWindowNackSent )
+				{
+					SendWindowNoAcknowledge(SequenceError);
+					isWindowNackSent = true;
+				}
+			}
+			break;
+
+		case WRITE_SEQUENCED_PROGRAM_TO_FLASH:
+#ifdef TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE
+			isWriteSuccessful = true;
+#else
+			isWriteSuccessful = PC2UART_WriteData(rx_data_packet.item.command, &pRxPayload[1], rx_data_packet.item.size - DataPacketOverheadSequenced);
+#endif
+			if( isWriteSuccessful )
+			{
+				expectedSequenceNumber++;
+				unacknowledgedCount++;
+				isWindowNackSent = false;
+				/*
+				 * Acknowledge cumulatively, either when enough data packets are written
+				 * or when the PC has stopped sending (nothing left in the ring buffer).
+				 */
+#ifdef PC2UART_FRAMING_COBS
+				// Empty frames between two data packets (an extra delimiter) are not data from the PC.
+				PC2UART_DropCobsDelimiters();
+#endif
+				if( (unacknowledgedCount >= PC2UART_ACK_INTERVAL) || FifoRingBuffer_IsEmpty() )
+				{
+					SendWindowAcknowledge();
+				}
+			}
+			else
+			{
+				SendWindowNoAcknowledge(WriteFlashMemoryError);
+				isWindowNackSent = true;
+			}
+			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+			break;
+
 		case UPDATE_FIRMWARE_STATUS:
 			// All data packet transfer has ended.
 			LED_OFF;
+			// Write the rest of the new firmware rebuilt from a delta patch or a compressed image.
+			isDownloadComplete = PC2UART_FinishData();
 			// Calculate the size of the new firmware.
 			new_firmware_status.newFirmwareSize = calculateNewFirmwareSize();
 
@@ -405,7 +590,7 @@ void PC2UART_receiver_run(void)
 			}
 
 			// Set the firmware update flag
-			if(rx_data_packet.item.command == ResetOK)
+			if( (rx_data_packet.item.command == ResetOK) && isDownloadComplete )
 			{
 #ifdef DEBUG_FROM_RAM
 				// Successful in new firmware downloading.
@@ -415,7 +600,7 @@ void PC2UART_receiver_run(void)
 				new_firmware_status.isNewFirmwareUpdated = 1u;
 			}
 
-			if(rx_data_packet.item.command == ResetNotOK)
+			if( (rx_data_packet.item.command == ResetNotOK) || (!isDownloadComplete) )
 			{
 #ifdef DEBUG_FROM_RAM
 				// Failed in new firmware downloading.
@@ -424,10 +609,19 @@ void PC2UART_receiver_run(void)
 				// New firmware is not updated
 				new_firmware_status.isNewFirmwareUpdated = 0u;
 			}
+#ifdef DEBUG_FROM_RAM
+			printf("RX ring buffer: high water mark %lu, overrun %lu\r\n",
+				   (unsigned long)uart_rx_ring_buffer.highWaterMark, (unsigned long)uart_rx_ring_buffer.overrunCount);
+#endif
+
+			// The new firmware has not been installed yet.
+			new_firmware_status.installedSectorNum = 0u;
 
 			// Store the new firmware status into EEPROM for use in next restart.
 #ifndef	TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE
 			isWriteSuccessful = eeprom_write_new_firmware_status();
+			// The download has ended, there is nothing to resume any more.
+			flash_auto_write_resume_clear();
 #endif
 			PC2UART_ReceiverStatus = RESET_MCU;
 			break;
@@ -510,87 +704,418 @@ bool isDownloadTimeout( void )
 }
 
 /*
- * 	Check if the received data packet is correct.
- *  The checksum is calculated over the complete data packet.
- *  (header + type + size + raw_data[0..31] + checksum ) MOD 256 == 0
- *
- */
-bool isRxDataPacketCorrect( DATA_PACKET_t * pDataPacket )
-{
-	uint8_t i = 0;
-	uint8_t sum = 0;
-	for(i = 0; i < (pDataPacket->item.size - 1u); i++)
-	{
-		sum += pDataPacket->buffer[i];
-	}
-	sum += pDataPacket->item.checksum;
-	sum %= 256u;
-	if( sum == 0 )
-		return true;
-	else
-		return false;
-}
-
-/*
- * Check the data packet contents
- * @parameter:	pointer to the data packet
- * @return:		true if the data packet is what we expect
- * 				false if the data packet is not what we expect
+ * Parse the received bytes into rx_data_packet, the receiver status is the parser state.
+ * All bytes in the ring buffer are drained per call: the header is searched by memchr() over the
+ * contiguous received bytes. The data payload is left in the ring buffer (pRxPayload) if it is contiguous,
+ * otherwise it is copied by two block copies (at the ring buffer end).
+ * The previous data packet is released from the ring buffer first.
+ * @return:
+ * 		true:	a whole data packet has been received, the next bytes are left in the ring buffer
+ * 		false:	the ring buffer is drained, the data packet is not complete yet
  */
-bool checkDataPacket( DATA_PACKET_t * pDataPacket )
+bool PC2UART_ParseDataPacket( void )
 {
-	// Check data packet header
-	if( pDataPacket->item.header != DataPacketHeader )
-	{
-		return false;
-	}
+	const uint8_t * pSpan = NULL;
+	const uint8_t * pHeader = NULL;
+	uint32_t spanByteNum = 0;
+	uint32_t payloadByteNum = 0;
+	uint8_t rxByte = 0;
 
-	// Check data packet type
-	if( pDataPacket->item.type != DataPacketType_PutData )
-	{
-		return false;
-	}
+	// The previous data packet has been handled.
+	FifoRingBuffer_Commit(rxHeldByteNum);
+	rxHeldByteNum = 0u;
 
-	// Check data size
-	// One data packet contains at least header, type, size, command and checksum.
-	if( pDataPacket->item.size < 5u )
+	if( isFirmwareDownloading && (PC2UART_ReceiverStatus == FIND_RX_DATA_PACKET_HEADER) )
 	{
-		return false;
+		LED_OFF;
 	}
 
-	// To print the reset command
-	if( pDataPacket->item.size == 5u )
+	while( (spanByteNum = FifoRingBuffer_GetSpan(&pSpan)) > 0u )
 	{
-//		printDataPacket(&rx_data_packet);
-	}
+		if( PC2UART_ReceiverStatus == FIND_RX_DATA_PACKET_HEADER )
+		{
+			pHeader = (const uint8_t *)memchr(pSpan, DataPacketHeader, spanByteNum);
+			if( pHeader == NULL )
+			{
+				// The data packet header is not found. Discard the span.
+				FifoRingBuffer_Commit(spanByteNum);
+				continue;
+			}
+			// The data packet header is found. Next to check data packet type
+			FifoRingBuffer_Commit((uint32_t)(pHeader - pSpan) + 1u);
+			rx_data_packet.item.header = DataPacketHeader;
+			PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_TYPE;
+			// Turn LED on to indicate the firmware download in progress.
+			LED_ON;
+			continue;
+		}
 
-	// Check PC command
-	if( (pDataPacket->item.command != WriteFlashMemory) &&
-		(pDataPacket->item.command != ResetOK) &&
-		(pDataPacket->item.command != ResetNotOK) )
-	{
-		// Unrecognized command
-		return false;
-	}
+		if( PC2UART_ReceiverStatus == EXTRACT_RX_DATA_PACKET )
+		{
+			// The data payload and the checksum (or CRC-16) behind it
+			payloadByteNum = rx_data_packet.item.size - DataPacketOverhead + DATA_PACKET_CHECK_LENGTH;
+			if( (rxPayloadByteCount == 0u) && (spanByteNum >= payloadByteNum) )
+			{
+				// The data payload and checksum are contiguous: hold them in the ring buffer.
+				pRxPayload = pSpan;
+				rxHeldByteNum = payloadByteNum;
+				return true;
+			}
+			if( (rxPayloadByteCount == 0u) && ((pSpan + spanByteNum) != &uart_rx_buffer[UART_RX_RING_BUFFER_SIZE]) )
+			{
+				// Wait for the rest of the data payload
+				return false;
+			}
+			// The data payload wraps around the ring buffer end, read it by two copies (behind the command)
+			if( spanByteNum > (payloadByteNum - rxPayloadByteCount) )
+			{
+				spanByteNum = payloadByteNum - rxPayloadByteCount;
+			}
+			memcpy(&rx_data_packet.buffer[4u + rxPayloadByteCount], pSpan, spanByteNum);
+			FifoRingBuffer_Commit(spanByteNum);
+			rxPayloadByteCount += spanByteNum;
+			if( rxPayloadByteCount == payloadByteNum )
+			{
+				pRxPayload = rx_data_packet.item.raw_data;
+				return true;
+			}
+			continue;
+		}
 
-	// Test the checksum
-	if( !isRxDataPacketCorrect(pDataPacket) )
-	{
-		return false;
-	}
+		// Type, size and command: one byte each
+		rxByte = pSpan[0];
+		FifoRingBuffer_Commit(1u);
+		switch( PC2UART_ReceiverStatus )
+		{
+			case CHECK_RX_DATA_PACKET_TYPE:
+				if( rxByte == DataPacketType_PutData )
+				{
+					// The data packet type is correct. Next to check data packet size.
+					rx_data_packet.item.type = rxByte;
+					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_SIZE;
+				}
+				else
+				{
+					// The data packet type is wrong. Restart to find the header.
+					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				}
+				break;
 
-	return true;
+			case CHECK_RX_DATA_PACKET_SIZE:
+				// One data packet contains at least header, type, size, command and checksum.
+				if( rxByte >= DataPacketOverhead )
+				{
+					// The data packet size is correct. Next to receive command.
+					rx_data_packet.item.size = rxByte;
+					PC2UART_ReceiverStatus = CHECK_RX_DATA_PACKET_CMD;
+				}
+				else
+				{
+					// The data packet size is wrong. Restart to find the header.
+					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				}
+				break;
+
+			case CHECK_RX_DATA_PACKET_CMD:
+				if( isRxDataPacketCommand(rxByte) )
+				{
+					// The data packet command is what we expect. Next to receive data payload and checksum.
+					rx_data_packet.item.command = rxByte;
+					rxPayloadByteCount = 0u;
+					PC2UART_ReceiverStatus = EXTRACT_RX_DATA_PACKET;
+					// Set the flag to indicate that the firmware is being downloaded.
+					if(isFirmwareDownloading == false)
+					{
+						isFirmwareDownloading = true;
+						countDownloadTime = 0;
+					}
+				}
+				else
+				{
+					// The data packet command is not what we expect. Restart to find the header.
+					PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				}
+				break;
+
+			default:
+				PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+				break;
+		}
+	}
+	return false;
+}
+
+#ifdef PC2UART_FRAMING_COBS
+/*
+ * Decode the received COBS frames into rx_data_packet, the receiver status is the parser state:
+ * FIND_RX_DATA_PACKET_HEADER between two frames, EXTRACT_RX_DATA_PACKET inside a frame.
+ * The code bytes are read one by one, the data bytes of a block by one or two block copies (at the ring buffer end).
+ * A frame that is not a data packet is skipped up to its delimiter, so the next frame is always found.
+ * @return:
+ * 		true:	a whole data packet has been received, the next bytes are left in the ring buffer
+ * 		false:	the ring buffer is drained, the data packet is not complete yet
+ */
+bool PC2UART_ParseCobsFrame( void )
+{
+	const uint8_t * pSpan = NULL;
+	const uint8_t * pDelimiter = NULL;
+	uint32_t spanByteNum = 0;
+	uint8_t rxByte = 0;
+
+	if( isFirmwareDownloading && (PC2UART_ReceiverStatus == FIND_RX_DATA_PACKET_HEADER) )
+	{
+		LED_OFF;
+	}
+
+	while( (spanByteNum = FifoRingBuffer_GetSpan(&pSpan)) > 0u )
+	{
+		if( isRxFrameDropped )
+		{
+			pDelimiter = (const uint8_t *)memchr(pSpan, COBS_FRAME_DELIMITER, spanByteNum);
+			if( pDelimiter == NULL )
+			{
+				FifoRingBuffer_Commit(spanByteNum);
+				continue;
+			}
+			// The next frame follows the delimiter.
+			FifoRingBuffer_Commit((uint32_t)(pDelimiter - pSpan) + 1u);
+			isRxFrameDropped = false;
+			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+			continue;
+		}
+
+		if( (PC2UART_ReceiverStatus == EXTRACT_RX_DATA_PACKET) && (cobsBlockByteNum > 0u) )
+		{
+			// The data bytes of the current block
+			if( spanByteNum > cobsBlockByteNum )
+			{
+				spanByteNum = cobsBlockByteNum;
+			}
+			if( (memchr(pSpan, COBS_FRAME_DELIMITER, spanByteNum) != NULL) ||
+				((rxFrameByteCount + spanByteNum) > DATA_PACKET_LENGTH) )
+			{
+				// The frame ends inside the block or is too long.
+				isRxFrameDropped = true;
+				continue;
+			}
+			memcpy(&rx_data_packet.buffer[rxFrameByteCount], pSpan, spanByteNum);
+			FifoRingBuffer_Commit(spanByteNum);
+			rxFrameByteCount += spanByteNum;
+			cobsBlockByteNum -= (uint8_t)spanByteNum;
+			continue;
+		}
+
+		// A code byte or the frame delimiter
+		rxByte = pSpan[0];
+		FifoRingBuffer_Commit(1u);
+		if( rxByte == COBS_FRAME_DELIMITER )
+		{
+			if( PC2UART_ReceiverStatus == FIND_RX_DATA_PACKET_HEADER )
+			{
+				// No frame between two delimiters (e.g. the idle line after the delimiter)
+				continue;
+			}
+			PC2UART_ReceiverStatus = FIND_RX_DATA_PACKET_HEADER;
+			if( isRxCobsFrameDataPacket() )
+			{
+				return true;
+			}
+			continue;
+		}
+		if( PC2UART_ReceiverStatus != EXTRACT_RX_DATA_PACKET )
+		{
+			// The first code byte of a frame
+			rxFrameByteCount = 0u;
+			PC2UART_ReceiverStatus = EXTRACT_RX_DATA_PACKET;
+			// Turn LED on to indicate the firmware download in progress.
+			LED_ON;
+		}
+		else if( cobsBlockCode != 0xFFu )
+		{
+			// The previous block is followed by a zero
+			if( rxFrameByteCount >= DATA_PACKET_LENGTH )
+			{
+				isRxFrameDropped = true;
+				continue;
+			}
+			rx_data_packet.buffer[rxFrameByteCount++] = 0u;
+		}
+		cobsBlockCode = rxByte;
+		cobsBlockByteNum = rxByte - 1u;
+	}
+	return false;
+}
+
+/*
+ * Remove the delimiters waiting in the ring buffer before the next frame, called between two frames only.
+ */
+void PC2UART_DropCobsDelimiters( void )
+{
+	const uint8_t * pSpan = NULL;
+	uint32_t spanByteNum = 0;
+	uint32_t i = 0;
+
+	while( (spanByteNum = FifoRingBuffer_GetSpan(&pSpan)) > 0u )
+	{
+		i = 0;
+		while( (i < spanByteNum) && (pSpan[i] == COBS_FRAME_DELIMITER) )
+		{
+			i++;
+		}
+		FifoRingBuffer_Commit(i);
+		if( i < spanByteNum )
+		{
+			break;
+		}
+	}
 }
 
-void printDataPacket( DATA_PACKET_t * pDataPacket )
+/*
+ * Check that the decoded frame is a whole data packet: the header, type, size and command fields
+ * are checked like the bytes of an unframed data packet, and the size must be the frame length.
+ */
+bool isRxCobsFrameDataPacket( void )
 {
+	if( (rxFrameByteCount < DataPacketOverhead) ||
+		(rx_data_packet.item.header != DataPacketHeader) ||
+		(rx_data_packet.item.type != DataPacketType_PutData) ||
+		(rx_data_packet.item.size != rxFrameByteCount) ||
+		(!isRxDataPacketCommand(rx_data_packet.item.command)) )
+	{
+		return false;
+	}
+	pRxPayload = rx_data_packet.item.raw_data;
+	// Set the flag to indicate that the firmware is being downloaded.
+	if(isFirmwareDownloading == false)
+	{
+		isFirmwareDownloading = true;
+		countDownloadTime = 0;
+	}
+	return true;
+}
+#endif
+
+// Check if the byte is a PC command, the only list of the accepted PC commands
+bool isRxDataPacketCommand( uint8_t command )
+{
+	return ( (command == WriteFlashMemory) ||
+			 (command == WriteFlashMemorySequenced) ||
+			 (command == WriteDeltaPatchSequenced) ||
+			 (command == WriteCompressedSequenced) ||
+			 (command == SetBaudRate) ||
+			 (command == QueryResumePoint) ||
+			 (command == DumpTrace) ||
+			 (command == ResetOK) ||
+			 (command == ResetNotOK) );
+}
+
+/*
+ * 	Check if the received data packet is correct.
+ *  The checksum is calculated over the complete data packet.
+ *  (header + type + size + command + payload[0..] + checksum ) MOD 256 == 0
+ *  PC2UART_FRAME_CRC16: the CRC-16 of header, type, size, command and payload[0..] is the 2 bytes behind the payload.
+ *
+ */
+bool isRxDataPacketCorrect( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload )
+{
+	uint8_t payloadByteNum = pDataPacket->item.size - DataPacketOverhead;
+#ifdef PC2UART_FRAME_CRC16
+	uint16_t crc = CRC16_SEED;
+
+	crc = crc16_update(crc, pDataPacket->buffer, 4u);
+	crc = crc16_update(crc, pPayload, payloadByteNum);
+	return ( crc == ((uint16_t)pPayload[payloadByteNum] | ((uint16_t)pPayload[payloadByteNum + 1u] << 8)) );
+#else
 	uint8_t i = 0;
-	printf("Data Packet:");
-	for( i = 0; i < pDataPacket->item.size - 1u; i++ )
+	uint8_t sum = 0;
+	sum = pDataPacket->item.header + pDataPacket->item.type + pDataPacket->item.size + pDataPacket->item.command;
+	for(i = 0; i < payloadByteNum; i++)
 	{
-		printf(" %02x", pDataPacket->buffer[i]);
+		sum += pPayload[i];
 	}
-	printf(" %02x\r\n", pDataPacket->item.checksum);
+	sum += pPayload[payloadByteNum];
+	sum %= 256u;
+	if( sum == 0 )
+		return true;
+	else
+		return false;
+#endif
+}
+
+/*
+ * Check the size of the program data carried by a data packet
+ * @parameter:	the number of program data bytes
+ * @return:		true if it is a non-zero multiple of PROGRAM_DATA_UNIT_SIZE and at most PROGRAM_DATA_MAX_SIZE
+ */
+bool isProgramDataSizeValid( uint32_t programDataSize )
+{
+	if( (programDataSize == 0u) || (programDataSize > PROGRAM_DATA_MAX_SIZE) )
+	{
+		return false;
+	}
+	return ((programDataSize % PROGRAM_DATA_UNIT_SIZE) == 0u);
+}
+
+/*
+ * Check the data packet contents
+ * @parameter:	pointer to the data packet, pointer to its data payload
+ * @return:		true if the data packet is what we expect
+ * 				false if the data packet is not what we expect
+ */
+bool checkDataPacket( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload )
+{
+	// Check data packet header
+	if( pDataPacket->item.header != DataPacketHeader )
+	{
+		return false;
+	}
+
+	// Check data packet type
+	if( pDataPacket->item.type != DataPacketType_PutData )
+	{
+		return false;
+	}
+
+	// Check data size
+	// One data packet contains at least header, type, size, command and checksum.
+	if( pDataPacket->item.size < DataPacketOverhead )
+	{
+		return false;
+	}
+
+	// To print the reset command
+	if( pDataPacket->item.size == DataPacketOverhead )
+	{
+//		printDataPacket(pDataPacket, pPayload);
+	}
+
+	// Check PC command
+	if( !isRxDataPacketCommand(pDataPacket->item.command) )
+	{
+		// Unrecognized command
+		return false;
+	}
+
+	// Test the checksum
+	if( !isRxDataPacketCorrect(pDataPacket, pPayload) )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void printDataPacket( DATA_PACKET_t * pDataPacket, const uint8_t * pPayload )
+{
+	uint8_t i = 0;
+	printf("Data Packet: %02x %02x %02x %02x", pDataPacket->item.header, pDataPacket->item.type,
+		   pDataPacket->item.size, pDataPacket->item.command);
+	// The data payload and the checksum (or CRC-16)
+	for( i = 0; i < pDataPacket->item.size - DataPacketOverhead + DATA_PACKET_CHECK_LENGTH; i++ )
+	{
+		printf(" %02x", pPayload[i]);
+	}
+	printf("\r\n");
 }
 
 void calculateChecksum( DATA_PACKET_t * pDataPacket )
@@ -646,51 +1171,376 @@ void SendNoAcknowledge(uint8_t errorInfo)
 	LPUART_DRV_SendDataPolling(INST_LPUART0, nack_data_packet.buffer, sizeof(nack_data_packet.buffer));
 }
 
+// Send the resume point back to the PC
+void SendResumePoint(uint32_t resumeOffset)
+{
+	RESUME_POINT_DATA_PACKET_t resume_data_packet;
+	resume_data_packet.item.header = DataPacketHeader;
+	resume_data_packet.item.type = RESUME_CODE;
+	resume_data_packet.item.size = RESUME_POINT_DATA_PACKET_LENGTH;
+	resume_data_packet.item.offset[0] = (uint8_t)resumeOffset;
+	resume_data_packet.item.offset[1] = (uint8_t)(resumeOffset >> 8);
+	resume_data_packet.item.offset[2] = (uint8_t)(resumeOffset >> 16);
+	resume_data_packet.item.offset[3] = (uint8_t)(resumeOffset >> 24);
+	// Calculate the checksum
+	uint8_t checksum = 0u;
+	uint8_t i = 0;
+	for( i = 0; i < (RESUME_POINT_DATA_PACKET_LENGTH - 1u); i++ )
+	{
+		checksum -= resume_data_packet.buffer[i];
+	}
+	resume_data_packet.item.checksum = checksum;
+	LPUART_DRV_SendDataPolling(INST_LPUART0, resume_data_packet.buffer, sizeof(resume_data_packet.buffer));
+}
+
+// Send the trace entries from the first index on back to the PC
+void SendTrace(uint16_t firstIndex)
+{
+	uint8_t trace_data_packet[TRACE_DATA_PACKET_HEADER_LENGTH + (TRACE_DATA_PACKET_MAX_ENTRIES * TRACE_DATA_PACKET_ENTRY_LENGTH) + 1u];
+	uint32_t entryNum = trace_get_count();
+	uint32_t coreClock = 0u;
+	TRACE_ENTRY_t entry;
+	uint8_t count = 0u;
+	uint8_t size = 0u;
+	uint8_t * pEntry = NULL;
+
+	CLOCK_SYS_GetFreq(CORE_CLOCK, &coreClock);
+	trace_data_packet[0] = DataPacketHeader;
+	trace_data_packet[1] = TRACE_CODE;
+	trace_data_packet[3] = (uint8_t)entryNum;
+	trace_data_packet[4] = (uint8_t)(entryNum >> 8);
+	trace_data_packet[5] = (uint8_t)firstIndex;
+	trace_data_packet[6] = (uint8_t)(firstIndex >> 8);
+	trace_data_packet[7] = (uint8_t)coreClock;
+	trace_data_packet[8] = (uint8_t)(coreClock >> 8);
+	trace_data_packet[9] = (uint8_t)(coreClock >> 16);
+	trace_data_packet[10] = (uint8_t)(coreClock >> 24);
+	while( (count < TRACE_DATA_PACKET_MAX_ENTRIES) && trace_get_entry((uint32_t)firstIndex + count, &entry) )
+	{
+		pEntry = &trace_data_packet[TRACE_DATA_PACKET_HEADER_LENGTH + (count * TRACE_DATA_PACKET_ENTRY_LENGTH)];
+		pEntry[0] = (uint8_t)entry.cycles;
+		pEntry[1] = (uint8_t)(entry.cycles >> 8);
+		pEntry[2] = (uint8_t)(entry.cycles >> 16);
+		pEntry[3] = (uint8_t)(entry.cycles >> 24);
+		pEntry[4] = entry.event;
+		pEntry[5] = entry.phase;
+		pEntry[6] = (uint8_t)entry.arg;
+		pEntry[7] = (uint8_t)(entry.arg >> 8);
+		count++;
+	}
+	trace_data_packet[11] = count;
+	size = (uint8_t)(TRACE_DATA_PACKET_HEADER_LENGTH + (count * TRACE_DATA_PACKET_ENTRY_LENGTH) + 1u);
+	trace_data_packet[2] = size;
+	// Calculate the checksum
+	uint8_t checksum = 0u;
+	uint8_t i = 0;
+	for( i = 0; i < (size - 1u); i++ )
+	{
+		checksum -= trace_data_packet[i];
+	}
+	trace_data_packet[size - 1u] = checksum;
+	LPUART_DRV_SendDataPolling(INST_LPUART0, trace_data_packet, size);
+}
+
+// Send the sliding window cumulative acknowledge back to the PC
+void SendWindowAcknowledge(void)
+{
+	WINDOW_ACK_DATA_PACKET_t ack_data_packet;
+	ack_data_packet.item.header = DataPacketHeader;
+	ack_data_packet.item.type = ACK_SEQ_CODE;
+	ack_data_packet.item.size = WINDOW_ACK_DATA_PACKET_LENGTH;
+	// The last sequence number written to flash
+	ack_data_packet.item.sequence = (uint8_t)(expectedSequenceNumber - 1u);
+	// Calculate the checksum
+	uint8_t checksum = 0u;
+	uint8_t i = 0;
+	for( i = 0; i < (WINDOW_ACK_DATA_PACKET_LENGTH - 1u); i++ )
+	{
+		checksum -= ack_data_packet.buffer[i];
+	}
+	ack_data_packet.item.checksum = checksum;
+	LPUART_DRV_SendDataPolling(INST_LPUART0, ack_data_packet.buffer, sizeof(ack_data_packet.buffer));
+	unacknowledgedCount = 0u;
+}
+
+// Send the sliding window no acknowledge back to the PC
+void SendWindowNoAcknowledge(uint8_t errorInfo)
+{
+	WINDOW_NACK_DATA_PACKET_t nack_data_packet;
+	nack_data_packet.item.header = DataPacketHeader;
+	nack_data_packet.item.type = ERR_SEQ_CODE;
+	nack_data_packet.item.size = WINDOW_NACK_DATA_PACKET_LENGTH;
+	nack_data_packet.item.error_info = errorInfo;
+	// The PC shall go back and resend from this sequence number
+	nack_data_packet.item.sequence = expectedSequenceNumber;
+	// Calculate the checksum
+	uint8_t checksum = 0u;
+	uint8_t i = 0;
+	for( i = 0; i < (WINDOW_NACK_DATA_PACKET_LENGTH - 1u); i++ )
+	{
+		checksum -= nack_data_packet.buffer[i];
+	}
+	nack_data_packet.item.checksum = checksum;
+	LPUART_DRV_SendDataPolling(INST_LPUART0, nack_data_packet.buffer, sizeof(nack_data_packet.buffer));
+}
+
 /*
- * FIFO Buffer Operation Function
+ * Switch the LPUART0 baud rate.
+ * OSR and SBR may only be changed while both the transmitter and the receiver are disabled.
  */
-// Check if the RX FIFO Ring Buffer is empty.
-bool FifoRingBuffer_IsEmpty(void)
+void PC2UART_ApplyBaudRate(uint32_t baudRate)
 {
-	if( uart_rx_ring_buffer.usedBytesCount == 0 )
+	uint32_t currentBaudRate = 0u;
+	LPUART_DRV_GetBaudRate(INST_LPUART0, &currentBaudRate);
+	if( currentBaudRate == baudRate )
 	{
-		return true;
+		return;
 	}
-	else
+	// Let the last byte be shifted out completely.
+	while( (LPUART0->STAT & LPUART_STAT_TC_MASK) == 0u )
+	{
+	}
+	LPUART0->CTRL &= ~(LPUART_CTRL_TE_MASK | LPUART_CTRL_RE_MASK);
+	LPUART_DRV_SetBaudRate(INST_LPUART0, baudRate);
+	LPUART0->CTRL |= (LPUART_CTRL_TE_MASK | LPUART_CTRL_RE_MASK);
+}
+
+/*
+ * Check if the proposed baud rate can be generated from the LPUART clock,
+ * acknowledge it at the current baud rate and switch.
+ * @return:
+ * 		true:	switched to the new baud rate, waiting for the confirmation
+ * 		false:	the baud rate is rejected
+ */
+bool PC2UART_NegotiateBaudRate(uint32_t desiredBaudRate)
+{
+	uint32_t lpuartSourceClock = 0u;
+	uint32_t currentBaudRate = 0u;
+	uint32_t configuredBaudRate = 0u;
+	uint32_t baudRateDiff = 0u;
+
+	(void)CLOCK_SYS_GetFreq(LPUART0_CLK, &lpuartSourceClock);
+	if( (desiredBaudRate == 0u) || (desiredBaudRate > PC2UART_MAX_BAUD_RATE) ||
+		(lpuartSourceClock < (desiredBaudRate * 4u)) )
+	{
+		// The smallest over-sampling ratio is 4.
+		SendNoAcknowledge(BaudRateError);
+		return false;
+	}
+
+	// Let the SDK calculate the best OSR and SBR, read back the baud rate they generate, then restore.
+	LPUART_DRV_GetBaudRate(INST_LPUART0, &currentBaudRate);
+	PC2UART_ApplyBaudRate(desiredBaudRate);
+	LPUART_DRV_GetBaudRate(INST_LPUART0, &configuredBaudRate);
+	PC2UART_ApplyBaudRate(currentBaudRate);
+
+	baudRateDiff = (configuredBaudRate > desiredBaudRate) ? (configuredBaudRate - desiredBaudRate) : (desiredBaudRate - configuredBaudRate);
+	if( ((uint64_t)baudRateDiff * 1000u) > ((uint64_t)desiredBaudRate * PC2UART_BAUD_RATE_MAX_ERROR) )
 	{
+		SendNoAcknowledge(BaudRateError);
 		return false;
 	}
+
+	// Acknowledge at the current baud rate, then switch.
+	SendAcknowledge();
+	PC2UART_ApplyBaudRate(desiredBaudRate);
+	FifoRingBuffer_Flush();
+
+	previousBaudRate = currentBaudRate;
+	baudRateSwitchTime = countDownloadTime;
+	isBaudRateConfirmPending = true;
+	return true;
 }
 
-// Check if the RX FIFO Ring Buffer is full.
-bool FifoRingBuffer_IsFull(void)
+/*
+ * Confirm the new baud rate by the first data packet received after the switch.
+ * @return:
+ * 		true:	the new baud rate is kept
+ * 		false:	fell back to the previous baud rate
+ */
+bool PC2UART_ConfirmBaudRate(bool isFirstPacketCorrect)
 {
-	if( uart_rx_ring_buffer.usedBytesCount == uart_rx_ring_buffer.size )
+	isBaudRateConfirmPending = false;
+	if( isFirstPacketCorrect )
 	{
 		return true;
 	}
-	else
+	PC2UART_ApplyBaudRate(previousBaudRate);
+	FifoRingBuffer_Flush();
+	return false;
+}
+
+/*
+ * Pass the data of a data packet to the firmware image, the delta patch decoder or the decompressor.
+ * @param:
+ * 		command: the data command of the data packet
+ * 		pData: the data
+ * 		byteNum: the number of data bytes
+ * @return:
+ * 		true if the data are accepted and the new firmware is written so far
+ */
+bool PC2UART_WriteData(uint8_t command, const uint8_t * pData, uint32_t byteNum)
+{
+	if( downloadDataCommand == 0u )
+	{
+		downloadDataCommand = command;
+	}
+	if( command != downloadDataCommand )
 	{
+		// A download cannot mix a plain image, a delta patch and a compressed image.
 		return false;
 	}
+	if( isDownloadResumable && (command != WriteFlashMemory) && (command != WriteFlashMemorySequenced) )
+	{
+		// The decoder state of a delta patch or a compressed image cannot be resumed.
+		return false;
+	}
+
+	if( command == WriteDeltaPatchSequenced )
+	{
+		return delta_patch_input(pData, byteNum);
+	}
+	if( command == WriteCompressedSequenced )
+	{
+		return lz4_stream_input(pData, byteNum);
+	}
+	return flash_auto_write_bytes(pData, byteNum);
+}
+
+/*
+ * Start a resumable download (PC command QueryResumePoint) and tell the PC where to continue.
+ * The data packets of the resumed download are numbered from 0 again.
+ * @param:
+ * 		imageId: the id of the image to download (the CRC-32 of the plain image)
+ */
+void PC2UART_ResumeDownload(uint32_t imageId)
+{
+	uint32_t resumeOffset = 0;
+
+#ifndef TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE
+	resumeOffset = flash_auto_write_resume(imageId);
+#endif
+	expectedSequenceNumber = 0u;
+	unacknowledgedCount = 0u;
+	isWindowNackSent = false;
+	downloadDataCommand = 0u;
+	isDownloadResumable = true;
+	SendResumePoint(resumeOffset);
 }
 
-// Put a byte into the RX FIFO Ring Buffer
+/*
+ * Write the rest of the new firmware after the last data packet.
+ * @return:
+ * 		true if the new firmware is complete
+ */
+bool PC2UART_FinishData(void)
+{
+#ifdef TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE
+	return true;
+#else
+	if( downloadDataCommand == WriteDeltaPatchSequenced )
+	{
+		return delta_patch_finish();
+	}
+	if( downloadDataCommand == WriteCompressedSequenced )
+	{
+		return lz4_stream_finish();
+	}
+	return true;
+#endif
+}
+
+#ifdef UART_RX_USE_DMA
+/*
+ * Start the eDMA loop transfer from the LPUART0 DATA register into the RX ring buffer.
+ */
+void UartRxDma_init(void)
+{
+	EDMA_DRV_Init(&dmaController1_State, &dmaController1_InitConfig0, edmaChnStateArray, edmaChnConfigArray, 0u);
+	EDMA_DRV_ChannelInit(&dmaController1Chn0_State, &uart_rx_dma_channel_config);
+
+	uart_rx_dma_transfer_config.srcAddr = (uint32_t)&(LPUART0->DATA);
+	uart_rx_dma_transfer_config.destAddr = (uint32_t)uart_rx_buffer;
+	EDMA_DRV_ConfigLoopTransfer(UART_RX_DMA_CHANNEL, &uart_rx_dma_transfer_config);
+	/*
+	 * The eDMA interrupt handlers run from P-Flash.
+	 * The loop never completes from the receiver point of view, so no interrupt is needed.
+	 */
+	EDMA_DRV_ConfigureInterrupt(UART_RX_DMA_CHANNEL, EDMA_CHN_MAJOR_LOOP_INT, false);
+	EDMA_DRV_StartChannel(UART_RX_DMA_CHANNEL);
+
+	// Let LPUART0 request an eDMA transfer for each received byte.
+	LPUART0->BAUD |= LPUART_BAUD_RDMAE_MASK;
+}
+
+/*
+ * Update the ring buffer put index from the eDMA destination position.
+ * The remaining major loop count tells how many bytes are left until the eDMA wraps around.
+ * The eDMA overwrites the oldest bytes when the ring buffer is full, which cannot be counted here.
+ */
+void FifoRingBuffer_UpdateFromDma(void)
+{
+	uint32_t remaining = EDMA_DRV_GetRemainingMajorIterationsCount(UART_RX_DMA_CHANNEL);
+	uint32_t getByteIndex = uart_rx_ring_buffer.getByteIndex;
+	uint32_t usedBytesCount = ((UART_RX_RING_BUFFER_SIZE - remaining) - getByteIndex) & UART_RX_RING_BUFFER_MASK;
+
+	uart_rx_ring_buffer.putByteIndex = getByteIndex + usedBytesCount;
+	if( usedBytesCount > uart_rx_ring_buffer.highWaterMark )
+	{
+		uart_rx_ring_buffer.highWaterMark = usedBytesCount;
+	}
+}
+#endif
+
+/*
+ * FIFO Buffer Operation Function
+ */
+// Check if the RX FIFO Ring Buffer is empty. The bytes of the held data packet do not count.
+bool FifoRingBuffer_IsEmpty(void)
+{
+#ifdef UART_RX_USE_DMA
+	FifoRingBuffer_UpdateFromDma();
+#endif
+	return ((uart_rx_ring_buffer.putByteIndex - uart_rx_ring_buffer.getByteIndex) <= rxHeldByteNum);
+}
+
+// Check if the RX FIFO Ring Buffer is full.
+START_FUNCTION_DEFINITION_RAMSECTION
+bool FifoRingBuffer_IsFull(void)
+{
+	return ((uart_rx_ring_buffer.putByteIndex - uart_rx_ring_buffer.getByteIndex) >= UART_RX_RING_BUFFER_SIZE);
+}
+END_FUNCTION_DEFINITION_RAMSECTION
+
+// Put a byte into the RX FIFO Ring Buffer (producer)
+START_FUNCTION_DEFINITION_RAMSECTION
 bool FifoRingBuffer_PutByte(uint8_t InputByte)
 {
-	if(FifoRingBuffer_IsFull())
+	uint32_t putByteIndex = uart_rx_ring_buffer.putByteIndex;
+	uint32_t usedBytesCount = putByteIndex - uart_rx_ring_buffer.getByteIndex;
+
+	if( usedBytesCount >= UART_RX_RING_BUFFER_SIZE )
 	{
+		uart_rx_ring_buffer.overrunCount++;
 		return false;
 	}
-	uart_rx_ring_buffer.pRingBuffer[uart_rx_ring_buffer.putByteIndex] = InputByte;
-	uart_rx_ring_buffer.usedBytesCount++;
-	uart_rx_ring_buffer.putByteIndex = (uart_rx_ring_buffer.putByteIndex + 1) % uart_rx_ring_buffer.size;
+	uart_rx_ring_buffer.pRingBuffer[putByteIndex & UART_RX_RING_BUFFER_MASK] = InputByte;
+	// The byte must be in the ring buffer before the consumer can see it.
+	__asm volatile ("" : : : "memory");
+	uart_rx_ring_buffer.putByteIndex = putByteIndex + 1u;
+	if( (usedBytesCount + 1u) > uart_rx_ring_buffer.highWaterMark )
+	{
+		uart_rx_ring_buffer.highWaterMark = usedBytesCount + 1u;
+	}
 	return true;
 }
+END_FUNCTION_DEFINITION_RAMSECTION
 
-// Get a byte from the RX FIFO Ring Buffer
+// Get a byte from the RX FIFO Ring Buffer (consumer)
 bool FifoRingBuffer_GetByte(uint8_t * pOutputByte)
 {
+	uint32_t getByteIndex = uart_rx_ring_buffer.getByteIndex;
+
 	if(pOutputByte == NULL)
 	{
 		return false;
@@ -699,13 +1549,61 @@ bool FifoRingBuffer_GetByte(uint8_t * pOutputByte)
 	{
 		return false;
 	}
-	*pOutputByte = uart_rx_ring_buffer.pRingBuffer[uart_rx_ring_buffer.getByteIndex];
-	uart_rx_ring_buffer.usedBytesCount--;
-	uart_rx_ring_buffer.getByteIndex = (uart_rx_ring_buffer.getByteIndex + 1) % uart_rx_ring_buffer.size;
+	*pOutputByte = uart_rx_ring_buffer.pRingBuffer[getByteIndex & UART_RX_RING_BUFFER_MASK];
+	// The byte must be read before the producer can overwrite it.
+	__asm volatile ("" : : : "memory");
+	uart_rx_ring_buffer.getByteIndex = getByteIndex + 1u;
 	return true;
 }
 
-// UART Rx Callback for continuous byte by byte reception
+/*
+ * Get the received bytes that are contiguous in the RX FIFO Ring Buffer, without removing them (consumer).
+ * The bytes up to the end of the buffer are returned, the rest follows from the buffer start in the next span.
+ * @param:
+ * 		ppData: the first byte of the span
+ * @return:
+ * 		the number of bytes in the span, 0 if the ring buffer is empty
+ */
+uint32_t FifoRingBuffer_GetSpan(const uint8_t ** ppData)
+{
+	uint32_t getByteIndex = uart_rx_ring_buffer.getByteIndex;
+	uint32_t usedBytesCount = 0;
+	uint32_t contiguousBytesCount = UART_RX_RING_BUFFER_SIZE - (getByteIndex & UART_RX_RING_BUFFER_MASK);
+
+#ifdef UART_RX_USE_DMA
+	FifoRingBuffer_UpdateFromDma();
+#endif
+	usedBytesCount = uart_rx_ring_buffer.putByteIndex - getByteIndex;
+	*ppData = &uart_rx_ring_buffer.pRingBuffer[getByteIndex & UART_RX_RING_BUFFER_MASK];
+	return (usedBytesCount < contiguousBytesCount) ? usedBytesCount : contiguousBytesCount;
+}
+
+/*
+ * Remove the bytes of a span from the RX FIFO Ring Buffer after they have been used (consumer).
+ * @param:
+ * 		byteNum: at most the number of bytes returned by FifoRingBuffer_GetSpan()
+ */
+void FifoRingBuffer_Commit(uint32_t byteNum)
+{
+	// The bytes must be read before the producer can overwrite them.
+	__asm volatile ("" : : : "memory");
+	uart_rx_ring_buffer.getByteIndex += byteNum;
+}
+
+// Discard all bytes in the RX FIFO Ring Buffer (consumer), including the held data packet
+void FifoRingBuffer_Flush(void)
+{
+#ifdef UART_RX_USE_DMA
+	FifoRingBuffer_UpdateFromDma();
+#endif
+	rxHeldByteNum = 0u;
+#ifdef PC2UART_FRAMING_COBS
+	isRxFrameDropped = false;
+#endif
+	uart_rx_ring_buffer.getByteIndex = uart_rx_ring_buffer.putByteIndex;
+}
+
+// UART Rx Callback for continuous byte by byte reception (when the SDK handler serves the RX event)
 void handleRxByte(void *driverState, uart_event_t event, void *userData)
 {
 	uint8_t rxByte = 0;
@@ -720,3 +1618,70 @@ void handleRxByte(void *driverState, uart_event_t event, void *userData)
 		FifoRingBuffer_PutByte(rxByte);
 	}
 }
+
+/*
+ * LPUART0 RX & TX Interrupt for continuous byte by byte reception
+ *
+ * The RX data register full and idle line (COBS framing) events are served here directly from RAM.
+ * The other events (interrupt-driven TX of the idle message) are passed to the SDK handler,
+ * which runs from P-Flash and is therefore only called while no flash command is running.
+ */
+START_FUNCTION_DEFINITION_RAMSECTION
+void PC2UART_RxTx_IRQHandler(void)
+{
+	uint8_t rxByte = 0;
+	uint32_t status = LPUART0->STAT;
+	bool isRxByteReceived = ((LPUART0->CTRL & LPUART_CTRL_RIE_MASK) != 0u) && ((status & LPUART_STAT_RDRF_MASK) != 0u);
+#ifdef PC2UART_FRAMING_COBS
+	static uint8_t lastRxByte = COBS_FRAME_DELIMITER;	// The last byte put into the ring buffer
+#endif
+
+	if( isRxByteReceived )
+	{
+		rxByte = (uint8_t)LPUART0->DATA;
+	}
+
+#ifdef PC2UART_FRAMING_COBS
+	if( ((LPUART0->CTRL & LPUART_CTRL_ILIE_MASK) != 0u) && ((status & LPUART_STAT_IDLE_MASK) != 0u) )
+	{
+		/*
+		 * The PC has stopped sending: end the frame received so far by a delimiter, unless the PC has ended it
+		 * (the last byte in the ring buffer, or the byte still waiting in DATA, is the delimiter).
+		 * No extra byte follows a complete frame, which would hide the end of a window (FifoRingBuffer_IsEmpty).
+		 * Any other byte received at the same time belongs to the next frame, so the delimiter goes first.
+		 */
+		if( ((LPUART0->CTRL & LPUART_CTRL_RIE_MASK) != 0u) && (lastRxByte != COBS_FRAME_DELIMITER) &&
+			(!(isRxByteReceived && (rxByte == COBS_FRAME_DELIMITER))) )
+		{
+			FifoRingBuffer_PutByte(COBS_FRAME_DELIMITER);
+			lastRxByte = COBS_FRAME_DELIMITER;
+		}
+		LPUART0->STAT = (LPUART0->STAT & (~FEATURE_LPUART_STAT_REG_FLAGS_MASK)) | LPUART_STAT_IDLE_MASK;
+	}
+#endif
+
+	if( isRxByteReceived )
+	{
+		/*
+		 * Remove print function, otherwise the RX Overrun event will happen.
+		 */
+		FifoRingBuffer_PutByte(rxByte);
+#ifdef PC2UART_FRAMING_COBS
+		lastRxByte = rxByte;
+#endif
+	}
+
+	if( (status & LPUART_STAT_OR_MASK) != 0u )
+	{
+		// At least one received byte is lost.
+		uart_rx_ring_buffer.overrunCount++;
+		// Clear the overrun flag, otherwise the RX data register full flag will not be set any more.
+		LPUART0->STAT = (LPUART0->STAT & (~FEATURE_LPUART_STAT_REG_FLAGS_MASK)) | LPUART_STAT_OR_MASK;
+	}
+
+	if( (lpuart0_State.isTxBusy) && ((FTFC->FSTAT & FTFC_FSTAT_CCIF_MASK) != 0u) )
+	{
+		LPUART_DRV_IRQHandler(INST_LPUART0);
+	}
+}
+END_FUNCTION_DEFINITION_RAMSECTION
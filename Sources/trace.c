@@ -0,0 +1,123 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "trace.h"
+#include "stddef.h"
+#include "Cpu.h"
+
+#ifdef TRACE_ENABLE
+// Cortex-M4 debug registers of the cycle counter (not in the S32K144 device header)
+#define TRACE_DEMCR					(*((volatile uint32_t *)0xE000EDFCu))
+#define TRACE_DEMCR_TRCENA_MASK		(0x01000000u)
+#define TRACE_DWT_CTRL				(*((volatile uint32_t *)0xE0001000u))
+#define TRACE_DWT_CTRL_CYCCNTENA_MASK	(0x00000001u)
+#define TRACE_DWT_CYCCNT			(*((volatile uint32_t *)0xE0001004u))
+
+#define TRACE_RING_MAGIC			(0x54524143u)		// "TRAC"
+
+typedef struct
+{
+	uint32_t		magic;
+	uint32_t		putIndex;
+	uint32_t		count;
+	TRACE_ENTRY_t	entries[TRACE_RING_SIZE];
+} TRACE_RING_t;
+
+/*
+ * The ring is not cleared by the startup code (custom section, outside .bss),
+ * so the trace of the previous boot is kept over a warm reset.
+ */
+static TRACE_RING_t trace_Ring __attribute__((section (".customSection")));
+#endif
+
+/*
+ * Start the cycle counter and the trace of this boot.
+ * The ring is cleared after a power loss or if it does not hold a trace.
+ * @param:
+ * 		isPowerLost: a power loss since the last boot, the SRAM content is undefined
+ * 					 (reading it may give ECC errors), the ring is not read
+ */
+void trace_init(bool isPowerLost)
+{
+#ifdef TRACE_ENABLE
+	uint32_t resetSource = RCM->SRS;
+
+	TRACE_DEMCR |= TRACE_DEMCR_TRCENA_MASK;
+	TRACE_DWT_CYCCNT = 0u;
+	TRACE_DWT_CTRL |= TRACE_DWT_CTRL_CYCCNTENA_MASK;
+
+	if( isPowerLost ||
+		(trace_Ring.magic != TRACE_RING_MAGIC) ||
+		(trace_Ring.putIndex >= TRACE_RING_SIZE) || (trace_Ring.count > TRACE_RING_SIZE) )
+	{
+		trace_Ring.magic = TRACE_RING_MAGIC;
+		trace_Ring.putIndex = 0u;
+		trace_Ring.count = 0u;
+	}
+	trace_record(TRACE_EVENT_RESET, TRACE_PHASE_POINT, (uint16_t)resetSource);
+#else
+	(void)isPowerLost;
+#endif
+}
+
+/*
+ * Record one trace entry with the current cycle count.
+ * Called from the main loop context only.
+ */
+void trace_record(uint8_t event, uint8_t phase, uint16_t arg)
+{
+#ifdef TRACE_ENABLE
+	TRACE_ENTRY_t * pEntry = &trace_Ring.entries[trace_Ring.putIndex];
+
+	pEntry->cycles = TRACE_DWT_CYCCNT;
+	pEntry->event = event;
+	pEntry->phase = phase;
+	pEntry->arg = arg;
+	trace_Ring.putIndex = (trace_Ring.putIndex + 1u) % TRACE_RING_SIZE;
+	if( trace_Ring.count < TRACE_RING_SIZE )
+	{
+		trace_Ring.count++;
+	}
+#else
+	(void)event;
+	(void)phase;
+	(void)arg;
+#endif
+}
+
+/*
+ * @return:
+ * 		the number of entries in the ring
+ */
+uint32_t trace_get_count(void)
+{
+#ifdef TRACE_ENABLE
+	return trace_Ring.count;
+#else
+	return 0u;
+#endif
+}
+
+/*
+ * Read an entry of the ring.
+ * @param:
+ * 		index: 0 is the oldest entry
+ */
+bool trace_get_entry(uint32_t index, TRACE_ENTRY_t * pEntry)
+{
+#ifdef TRACE_ENABLE
+	if( (pEntry == NULL) || (index >= trace_Ring.count) )
+	{
+		return false;
+	}
+	*pEntry = trace_Ring.entries[(trace_Ring.putIndex + TRACE_RING_SIZE - trace_Ring.count + index) % TRACE_RING_SIZE];
+	return true;
+#else
+	(void)index;
+	(void)pEntry;
+	return false;
+#endif
+}
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+# delta_patch.py
+#
+#  Created on: Oct 18, 2026
+#
+# Generate or apply a delta patch for the bootloader (see include/delta_patch.h).
+#
+#   delta_patch.py diff  old.bin new.bin patch.bin
+#   delta_patch.py apply old.bin patch.bin new.bin
+#
+# old.bin is the firmware installed at 0x0000C000, new.bin the firmware to install.
+# The patch is sent with the WriteDeltaPatchSequenced (0x06) command instead of new.bin.
+
+import binascii
+import struct
+import sys
+
+MAGIC = b'DP'
+VERSION = 0x02
+HEADER_FORMAT = '<2sBBIIII'
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+# A match shorter than this costs more as a COPY (9 bytes) than as literal bytes.
+BLOCK_SIZE = 16
+MIN_COPY_LENGTH = 24
+MAX_INSERT_LENGTH = 0xFFFF
+
+
+def checksum(data):
+    # CRC-32 of the bytes, as crc32_calculate() (see include/crc32.h)
+    return binascii.crc32(data) & 0xFFFFFFFF
+
+
+def index_blocks(old):
+    index = {}
+    for offset in range(0, len(old) - BLOCK_SIZE + 1):
+        index.setdefault(old[offset:offset + BLOCK_SIZE], offset)
+    return index
+
+
+def find_match(old, new, position, index, last_copy_end):
+    # Prefer continuing right after the previous copy (unchanged code following a change).
+    best_offset, best_length = 0, 0
+    candidates = []
+    if last_copy_end is not None:
+        candidates.append(last_copy_end)
+    block = new[position:position + BLOCK_SIZE]
+    if len(block) == BLOCK_SIZE and block in index:
+        candidates.append(index[block])
+    for offset in candidates:
+        length = 0
+        while (position + length < len(new) and offset + length < len(old)
+               and new[position + length] == old[offset + length]):
+            length += 1
+        if length > best_length:
+            best_offset, best_length = offset, length
+    return best_offset, best_length
+
+
+def emit_insert(patch, literal):
+    for start in range(0, len(literal), MAX_INSERT_LENGTH):
+        chunk = literal[start:start + MAX_INSERT_LENGTH]
+        patch += struct.pack('<BH', OP_INSERT, len(chunk)) + chunk
+
+
+def diff(old, new):
+    patch = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, 0,
+                                  len(old), checksum(old), len(new), checksum(new)))
+    index = index_blocks(old)
+    literal = bytearray()
+    last_copy_end = None
+    position = 0
+    while position < len(new):
+        offset, length = find_match(old, new, position, index, last_copy_end)
+        if length >= MIN_COPY_LENGTH:
+            emit_insert(patch, literal)
+            literal = bytearray()
+            patch += struct.pack('<BII', OP_COPY, offset, length)
+            position += length
+            last_copy_end = offset + length
+        else:
+            literal.append(new[position])
+            position += 1
+            if last_copy_end is not None:
+                last_copy_end += 1
+    emit_insert(patch, literal)
+    patch.append(OP_END)
+    return bytes(patch)
+
+
+def apply(old, patch):
+    magic, version, _, old_size, old_sum, new_size, new_sum = struct.unpack_from(HEADER_FORMAT, patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not a delta patch')
+    if old_size > len(old) or checksum(old[:old_size]) != old_sum:
+        raise ValueError('the patch is made against another firmware')
+    old = old[:old_size]
+    new = bytearray()
+    position = struct.calcsize(HEADER_FORMAT)
+    while True:
+        opcode = patch[position]
+        position += 1
+        if opcode == OP_END:
+            break
+        if opcode == OP_COPY:
+            offset, length = struct.unpack_from('<II', patch, position)
+            position += 8
+            if offset + length > len(old):
+                raise ValueError('copy out of the old image')
+            new += old[offset:offset + length]
+        elif opcode == OP_INSERT:
+            (length,) = struct.unpack_from('<H', patch, position)
+            position += 2
+            new += patch[position:position + length]
+            position += length
+        else:
+            raise ValueError('unknown opcode 0x%02x' % opcode)
+    if position != len(patch):
+        raise ValueError('data after the end opcode')
+    if len(new) != new_size or checksum(new) != new_sum:
+        raise ValueError('the rebuilt image does not match the patch header')
+    return bytes(new)
+
+
+def main(argv):
+    if len(argv) != 5 or argv[1] not in ('diff', 'apply'):
+        print('usage: delta_patch.py diff old.bin new.bin patch.bin')
+        print('       delta_patch.py apply old.bin patch.bin new.bin')
+        return 1
+    with open(argv[2], 'rb') as f:
+        first = f.read()
+    with open(argv[3], 'rb') as f:
+        second = f.read()
+    if argv[1] == 'diff':
+        output = diff(first, second)
+        # Every patch is checked against the reference decoder before it is written.
+        if apply(first, output) != second:
+            raise RuntimeError('patch does not rebuild the new image')
+        print('patch size: %d bytes (%.1f%% of %d bytes)'
+              % (len(output), 100.0 * len(output) / max(len(second), 1), len(second)))
+    else:
+        output = apply(first, second)
+    with open(argv[4], 'wb') as f:
+        f.write(output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+#
+# download_benchmark.py
+#
+#  Created on: Oct 18, 2026
+#
+# Download throughput benchmark of the bootloader with the reference uploader (uploader.py).
+#
+#   download_benchmark.py --sim  [options]      the host simulation, Host/build/bootloader_sim (make -C Host)
+#   download_benchmark.py --port COM3 [options] a board with the bootloader waiting for a download
+#       --sizes 4096,65536          image sizes in bytes
+#       --bauds 115200,1000000      baud rates, switched by SetBaudRate
+#       --modes plain,window        plain: WriteFlashMemory (stop and wait), window: WriteFlashMemorySequenced
+#       --frame 248                 program data bytes per data packet
+#       --framing plain             plain or cobs, for a bootloader built with PC2UART_FRAMING_COBS
+#                                   (make -C Host DEFINES="-DPC2UART_FRAMING_COBS")
+#       --check sum                 sum or crc16, for a bootloader built with PC2UART_FRAME_CRC16
+#
+# Every download ends with ResetNotOK, so the image is not installed and the bootloader waits for the next one
+# (a board must not have an installed firmware). The simulation is started on new memory files for every download.
+#
+# The flash phases (erase, program, verify) are taken from the flash busy time of the simulation, or from the
+# phase trace of a board (bootloader built with TRACE_ENABLE, see trace_dump.py). The trace ring keeps the last
+# 128 entries only, the phases of a longer download are the sum of the traced ones (marked +).
+# Requires pyserial.
+
+import os
+import random
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+import serial
+
+import trace_dump
+import uploader
+
+SIM_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Host', 'build', 'bootloader_sim')
+SIM_FLASH_BUSY = re.compile(r'sim: flash busy: erase (\d+) x ([\d.]+) ms, program (\d+) x ([\d.]+) ms, '
+                            r'verify (\d+) x ([\d.]+) ms')
+
+# The image: a vector table (stack pointer, reset handler) and random code, which neither compresses nor repeats
+IMAGE_STACK_POINTER = 0x20007000
+IMAGE_RESET_HANDLER = 0x0000C411
+
+PHASES = ('erase', 'program', 'verify')
+TRACE_PHASES = {trace_dump.EVENTS[3]: 'erase', trace_dump.EVENTS[4]: 'program', trace_dump.EVENTS[5]: 'verify'}
+
+
+def make_image(size):
+    generator = random.Random(size)
+    code = bytes(generator.randrange(256) for _ in range(max(size - 8, 0)))
+    return struct.pack('<II', IMAGE_STACK_POINTER, IMAGE_RESET_HANDLER) + code
+
+
+class SimTarget(object):
+    # A new simulated MCU for every download
+
+    def __init__(self):
+        self.directory = tempfile.mkdtemp(prefix='bootloader_sim')
+        self.process = subprocess.Popen([SIM_PATH, '-p', os.path.join(self.directory, 'pflash.bin'),
+                                         '-e', os.path.join(self.directory, 'flexnvm.bin')],
+                                        stdout=subprocess.PIPE, universal_newlines=True, bufsize=1)
+        line = self.process.stdout.readline()
+        if not line.startswith('sim: LPUART0 is '):
+            self.close()
+            raise uploader.UploadError('the simulation did not start')
+        self.port = serial.Serial(line.split()[-1], uploader.DEFAULT_BAUD_RATE, timeout=1.0)
+
+    def phases(self):
+        # The flash busy time is printed at the reset after ResetNotOK
+        end = time.time() + 10.0
+        while time.time() < end:
+            line = self.process.stdout.readline()
+            if not line:
+                break
+            match = SIM_FLASH_BUSY.match(line)
+            if match:
+                values = [float(value) for value in match.groups()]
+                return dict((phase, (int(values[2 * i]), values[2 * i + 1], False)) for i, phase in enumerate(PHASES))
+        return None
+
+    def close(self):
+        if getattr(self, 'port', None):
+            self.port.close()
+        self.process.kill()
+        self.process.wait()
+        shutil.rmtree(self.directory, ignore_errors=True)
+
+
+class BoardTarget(object):
+
+    def __init__(self, port_name, framing, check):
+        self.port = serial.Serial(port_name, uploader.DEFAULT_BAUD_RATE, timeout=1.0)
+        self.framing = framing
+        self.check = check
+
+    def phases(self):
+        # The bootloader is back after ResetNotOK, at the default baud rate. The trace ring survives the reset.
+        self.port.baudrate = uploader.DEFAULT_BAUD_RATE
+        uploader.Bootloader(self.port).wait_ready()
+        entries, core_clock = trace_dump.read_trace(self.port, self.framing, self.check)
+        # The download is between the last two resets
+        resets = [i for i, entry in enumerate(entries) if entry[1] == 1]
+        if not core_clock or len(resets) == 0:
+            return None
+        first = resets[-2] + 1 if len(resets) >= 2 else 0
+        is_truncated = len(resets) < 2
+        totals = dict((phase, [0, 0.0]) for phase in PHASES)
+        open_phases = {}
+        for cycles, event, phase_type, arg in entries[first:resets[-1]]:
+            name = TRACE_PHASES.get(trace_dump.EVENTS.get(event))
+            if name is None:
+                continue
+            if phase_type == trace_dump.PHASE_BEGIN:
+                open_phases[name] = cycles
+            elif phase_type == trace_dump.PHASE_END and name in open_phases:
+                totals[name][0] += 1
+                totals[name][1] += ((cycles - open_phases.pop(name)) & 0xFFFFFFFF) * 1e3 / core_clock
+        return dict((phase, (count, total, is_truncated)) for phase, (count, total) in totals.items())
+
+    def close(self):
+        self.port.close()
+
+
+def run(target, image, mode, baud_rate, frame_size, framing, check):
+    bootloader = uploader.Bootloader(target.port)
+    bootloader.wait_ready()
+    statistics = uploader.upload(target.port, image, mode, baud_rate, frame_size, install=False, framing=framing,
+                                 check=check)
+    return statistics, target.phases()
+
+
+def format_phase(phases, phase):
+    if not phases:
+        return 'n/a'
+    count, total, is_truncated = phases[phase]
+    if count == 0:
+        return '-'
+    return '%.1f%s' % (total, '+' if is_truncated else '')
+
+
+def main(argv):
+    args = argv[1:]
+    options = {'--port': None, '--sizes': '4096,32768', '--bauds': '115200,1000000', '--modes': 'plain,window',
+               '--frame': str(uploader.PROGRAM_DATA_MAX_SIZE), '--framing': 'plain',
+               '--check': 'sum'}
+    use_sim = False
+    while args:
+        arg = args.pop(0)
+        if arg == '--sim':
+            use_sim = True
+        elif arg in options and args:
+            options[arg] = args.pop(0)
+        else:
+            options = None
+            break
+    if (options is None or use_sim == (options['--port'] is not None) or options['--framing'] not in uploader.FRAMINGS or
+            options['--check'] not in uploader.CHECKS):
+        print('usage: download_benchmark.py --sim | --port port [--sizes 4096,65536] [--bauds 115200,1000000]')
+        print('                             [--modes plain,window] [--frame 248] [--framing plain|cobs] [--check sum|crc16]')
+        return 1
+    if use_sim and not os.path.exists(SIM_PATH):
+        print('%s not found, build it by make -C Host' % SIM_PATH)
+        return 1
+    sizes = [int(size, 0) for size in options['--sizes'].split(',')]
+    baud_rates = [int(baud_rate) for baud_rate in options['--bauds'].split(',')]
+    modes = options['--modes'].split(',')
+    frame_size = int(options['--frame'])
+    framing = options['--framing']
+    check = options['--check']
+
+    print('%-7s %8s %8s %8s %9s %7s %6s %9s %10s %10s %10s'
+          % ('mode', 'size', 'baud', 'time [s]', 'bytes/s', 'frames', 'retx', 'ack [s]',
+             'erase [ms]', 'prog [ms]', 'verify [ms]'))
+    board = None if use_sim else BoardTarget(options['--port'], framing, check)
+    try:
+        for mode in modes:
+            for size in sizes:
+                for baud_rate in baud_rates:
+                    target = SimTarget() if use_sim else board
+                    try:
+                        statistics, phases = run(target, make_image(size), mode, baud_rate, frame_size, framing, check)
+                    except uploader.UploadError as error:
+                        print('%-7s %8d %8d  failed: %s' % (mode, size, baud_rate, error))
+                        continue
+                    finally:
+                        if use_sim:
+                            target.close()
+                    print('%-7s %8d %8d %8.2f %9.0f %7d %6d %9.2f %10s %10s %10s'
+                          % (mode, size, baud_rate, statistics.elapsed(), statistics.bytes_per_second(),
+                             statistics.frames, statistics.retransmissions, statistics.ack_wait,
+                             format_phase(phases, 'erase'), format_phase(phases, 'program'),
+                             format_phase(phases, 'verify')))
+                    sys.stdout.flush()
+    finally:
+        if board:
+            board.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+#
+# lz4_stream.py
+#
+#  Created on: Oct 18, 2026
+#
+# Compress or decompress a firmware image for the bootloader (see include/lz4_stream.h).
+#
+#   lz4_stream.py compress   new.bin new.lz
+#   lz4_stream.py decompress new.lz new.bin
+#
+# The compressed image is sent with the WriteCompressedSequenced (0x07) command instead of new.bin.
+
+import binascii
+import struct
+import sys
+
+MAGIC = b'LZ'
+VERSION = 0x02
+HEADER_FORMAT = '<2sBBII'
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+# The number of candidate positions tried for every hash (longer chains compress better but slower)
+MAX_CHAIN = 32
+
+
+def checksum(data):
+    # CRC-32 of the bytes, as crc32_calculate() (see include/crc32.h)
+    return binascii.crc32(data) & 0xFFFFFFFF
+
+
+def emit_length(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def emit_sequence(out, literals, offset, match_length):
+    literal_nibble = min(len(literals), 15)
+    match_nibble = 0 if match_length == 0 else min(match_length - MIN_MATCH, 15)
+    out.append((literal_nibble << 4) | match_nibble)
+    if literal_nibble == 15:
+        emit_length(out, len(literals) - 15)
+    out += literals
+    if match_length:
+        out += struct.pack('<H', offset)
+        if match_nibble == 15:
+            emit_length(out, match_length - MIN_MATCH - 15)
+
+
+def compress(data):
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, 0, len(data), checksum(data)))
+    chains = {}
+    literal_start = 0
+    position = 0
+    while position + MIN_MATCH <= len(data):
+        key = data[position:position + MIN_MATCH]
+        best_offset, best_length = 0, 0
+        for candidate in reversed(chains.get(key, [])[-MAX_CHAIN:]):
+            if position - candidate > MAX_OFFSET:
+                break
+            length = MIN_MATCH
+            while position + length < len(data) and data[candidate + length] == data[position + length]:
+                length += 1
+            if length > best_length:
+                best_offset, best_length = position - candidate, length
+        if best_length >= MIN_MATCH:
+            emit_sequence(out, data[literal_start:position], best_offset, best_length)
+            for p in range(position, min(position + best_length, len(data) - MIN_MATCH + 1)):
+                chains.setdefault(data[p:p + MIN_MATCH], []).append(p)
+            position += best_length
+            literal_start = position
+        else:
+            chains.setdefault(key, []).append(position)
+            position += 1
+    # The last sequence carries the remaining literals only.
+    emit_sequence(out, data[literal_start:], 0, 0)
+    return bytes(out)
+
+
+def read_length(data, position, length):
+    while True:
+        extra = data[position]
+        position += 1
+        length += extra
+        if extra != 255:
+            return position, length
+
+
+def decompress(data):
+    magic, version, _, size, image_sum = struct.unpack_from(HEADER_FORMAT, data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not a compressed image')
+    out = bytearray()
+    position = struct.calcsize(HEADER_FORMAT)
+    while True:
+        token = data[position]
+        position += 1
+        literal_length = token >> 4
+        if literal_length == 15:
+            position, literal_length = read_length(data, position, literal_length)
+        out += data[position:position + literal_length]
+        position += literal_length
+        # The last sequence ends after its literals.
+        if len(out) >= size:
+            break
+        (offset,) = struct.unpack_from('<H', data, position)
+        position += 2
+        match_length = (token & 0x0F) + MIN_MATCH
+        if (token & 0x0F) == 15:
+            position, match_length = read_length(data, position, match_length)
+        if offset == 0 or offset > len(out):
+            raise ValueError('match offset out of the image')
+        for _ in range(match_length):
+            out.append(out[-offset])
+    if position != len(data) or len(out) != size or checksum(out) != image_sum:
+        raise ValueError('the decompressed image does not match the header')
+    return bytes(out)
+
+
+def main(argv):
+    if len(argv) != 4 or argv[1] not in ('compress', 'decompress'):
+        print('usage: lz4_stream.py compress new.bin new.lz')
+        print('       lz4_stream.py decompress new.lz new.bin')
+        return 1
+    with open(argv[2], 'rb') as f:
+        data = f.read()
+    if argv[1] == 'compress':
+        output = compress(data)
+        # Every compressed image is checked against the reference decompressor before it is written.
+        if decompress(output) != data:
+            raise RuntimeError('compressed image does not decompress to the input')
+        print('compressed size: %d bytes (%.1f%% of %d bytes)'
+              % (len(output), 100.0 * len(output) / max(len(data), 1), len(data)))
+    else:
+        output = decompress(data)
+    with open(argv[3], 'wb') as f:
+        f.write(output)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+# trace_dump.py
+#
+#  Created on: Oct 18, 2026
+#
+# Read the phase latency trace of the bootloader (see include/trace.h) and print the phase durations.
+#
+#   trace_dump.py COM3 [baud rate] [plain|cobs] [sum|crc16]
+#
+# The bootloader must be built with TRACE_ENABLE and be waiting for a download.
+# cobs, crc16: the bootloader is built with PC2UART_FRAMING_COBS, PC2UART_FRAME_CRC16 (see uploader.py).
+# Requires pyserial.
+
+import struct
+import sys
+
+import serial
+
+import uploader
+
+DATA_PACKET_HEADER = 0x55
+DUMP_TRACE = 0x09
+TRACE_CODE = 0x15
+TRACE_HEADER_FORMAT = '<HHIB'
+TRACE_ENTRY_FORMAT = '<IBBH'
+
+EVENTS = {
+    1: 'reset',
+    2: 'firmware update',
+    3: 'erase sector',
+    4: 'program',
+    5: 'verify',
+    6: 'verify image',
+    7: 'eeprom write',
+    8: 'install sector',
+    9: 'jump',
+    10: 'fast boot',
+}
+PHASE_BEGIN, PHASE_END, PHASE_POINT = 0, 1, 2
+
+
+def read_trace_packet(port):
+    while True:
+        header = port.read(1)
+        if not header:
+            raise TimeoutError('no answer from the bootloader')
+        if header[0] == DATA_PACKET_HEADER:
+            break
+    packet_type, size = port.read(2)
+    body = port.read(size - 3)
+    if packet_type != TRACE_CODE or len(body) != size - 3:
+        raise ValueError('unexpected answer type 0x%02x' % packet_type)
+    if (DATA_PACKET_HEADER + packet_type + size + sum(body)) & 0xFF != 0:
+        raise ValueError('trace packet checksum error')
+    return body[:-1]
+
+
+def read_trace(port, framing='plain', check='sum'):
+    entries = []
+    while True:
+        packet = uploader.data_packet(DUMP_TRACE, struct.pack('<H', len(entries)), check)
+        port.write(uploader.cobs_encode(packet) if framing == 'cobs' else packet)
+        body = read_trace_packet(port)
+        entry_num, first_index, core_clock, count = struct.unpack_from(TRACE_HEADER_FORMAT, body)
+        offset = struct.calcsize(TRACE_HEADER_FORMAT)
+        for _ in range(count):
+            entries.append(struct.unpack_from(TRACE_ENTRY_FORMAT, body, offset))
+            offset += struct.calcsize(TRACE_ENTRY_FORMAT)
+        if count == 0 or len(entries) >= entry_num:
+            return entries, core_clock
+
+
+def print_trace(entries, core_clock):
+    us_per_cycle = 1e6 / core_clock if core_clock else 0.0
+    open_phases = {}
+    boot_start = None
+    print('%12s  %-16s %6s  %s' % ('time [us]', 'phase', 'arg', 'duration [us]'))
+    for cycles, event, phase, arg in entries:
+        name = EVENTS.get(event, 'event %d' % event)
+        if event == 1:
+            boot_start = cycles
+            open_phases.clear()
+            print('-' * 48)
+        elapsed = ((cycles - (boot_start or 0)) & 0xFFFFFFFF) * us_per_cycle
+        duration = ''
+        if phase == PHASE_BEGIN:
+            open_phases[event] = cycles
+            continue
+        if phase == PHASE_END and event in open_phases:
+            duration = '%.1f' % (((cycles - open_phases.pop(event)) & 0xFFFFFFFF) * us_per_cycle)
+        print('%12.1f  %-16s %6d  %s' % (elapsed, name, arg, duration))
+    # Phases without end, e.g. the boot decision ended by the jump to the firmware
+    for event, cycles in open_phases.items():
+        print('%12s  %-16s %6s  not ended' % ('', EVENTS.get(event, 'event %d' % event), ''))
+
+
+def main(argv):
+    if (len(argv) not in (2, 3, 4, 5) or (len(argv) >= 4 and argv[3] not in uploader.FRAMINGS) or
+            (len(argv) == 5 and argv[4] not in uploader.CHECKS)):
+        print('usage: trace_dump.py port [baud rate] [plain|cobs] [sum|crc16]')
+        return 1
+    baud_rate = int(argv[2]) if len(argv) >= 3 else 115200
+    with serial.Serial(argv[1], baud_rate, timeout=1.0) as port:
+        entries, core_clock = read_trace(port, argv[3] if len(argv) >= 4 else 'plain',
+                                         argv[4] if len(argv) == 5 else 'sum')
+    print('%d entries, core clock %d Hz' % (len(entries), core_clock))
+    print_trace(entries, core_clock)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
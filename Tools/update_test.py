@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# update_test.py
+#
+#  Created on: Oct 18, 2026
+#
+# Firmware update test of the bootloader on the host simulation (Host/build/bootloader_sim, make -C Host test).
+#
+#   update_test.py [--framing plain|cobs] [--check sum|crc16]
+#
+# Every case installs an old firmware A by a plain download, sends the new firmware B in the mode of the case,
+# installs it and compares the firmware in the simulated P-Flash with B:
+#   delta         delta(A->B) made by delta_patch.py, applied by the C decoder of the bootloader against the firmware
+#                 really installed in flash, not by the reference decoder of delta_patch.py
+#   compressed    B compressed by lz4_stream.py and decompressed by the C decoder of the bootloader
+#
+# A has an erased stack pointer, so the bootloader does not start it and waits for the next download, as if
+# A had returned to the bootloader. B has a valid entry vector, the test ends when the simulation jumps to it.
+# Requires pyserial.
+
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import serial
+
+import delta_patch
+import download_benchmark
+import lz4_stream
+import uploader
+
+OLD_FIRMWARE_START_ADDRESS = 0x0000C000
+JUMP_TIMEOUT = 30.0
+
+
+def make_images(size):
+    # B is A with a valid entry vector, a few changed and inserted ranges and a new tail, like a rebuilt firmware.
+    # The repeated table in the tail gives the LZ4 matches, the random code does not compress.
+    new = bytearray(download_benchmark.make_image(size))
+    old = bytearray(b'\xff' * 8) + new[8:]
+    generator = random.Random(size + 1)
+    for _ in range(4):
+        position = generator.randrange(8, len(new) - 64)
+        new[position:position + 16] = bytes(generator.randrange(256) for _ in range(16))
+    position = generator.randrange(8, len(new) - 64)
+    new[position:position] = bytes(generator.randrange(256) for _ in range(40))
+    new += bytes(generator.randrange(256) for _ in range(100)) + bytes(range(64)) * 16
+    return bytes(old), bytes(new)
+
+
+class Simulation(object):
+    # One simulated MCU on memory files kept over its resets
+
+    def __init__(self):
+        self.directory = tempfile.mkdtemp(prefix='bootloader_sim')
+        self.pflash_path = os.path.join(self.directory, 'pflash.bin')
+        self.process = subprocess.Popen([download_benchmark.SIM_PATH, '-p', self.pflash_path,
+                                         '-e', os.path.join(self.directory, 'flexnvm.bin'), '-t', '0'],
+                                        stdout=subprocess.PIPE, universal_newlines=True, bufsize=1)
+        line = self.process.stdout.readline()
+        if not line.startswith('sim: LPUART0 is '):
+            self.close()
+            raise uploader.UploadError('the simulation did not start')
+        self.port = serial.Serial(line.split()[-1], uploader.DEFAULT_BAUD_RATE, timeout=1.0)
+
+    def wait_ready(self):
+        # A reset restarts the bootloader at the default baud rate
+        self.port.baudrate = uploader.DEFAULT_BAUD_RATE
+        uploader.Bootloader(self.port).wait_ready()
+
+    def wait_jump(self):
+        # The simulation ends by the jump to the installed firmware
+        try:
+            output, _ = self.process.communicate(timeout=JUMP_TIMEOUT)
+        except subprocess.TimeoutExpired:
+            raise uploader.UploadError('the installed firmware is not started')
+        if self.process.returncode != 0 or 'sim: jump to firmware' not in output:
+            raise uploader.UploadError('the simulation ended without the jump to the firmware')
+
+    def read_pflash(self, address, size):
+        with open(self.pflash_path, 'rb') as f:
+            f.seek(address)
+            return f.read(size)
+
+    def close(self):
+        if getattr(self, 'port', None):
+            self.port.close()
+        if self.process.poll() is None:
+            self.process.kill()
+            self.process.wait()
+        shutil.rmtree(self.directory, ignore_errors=True)
+
+
+def run_case(mode, old, new, framing, check):
+    if mode == 'delta':
+        image = delta_patch.diff(old, new)
+    else:
+        image = lz4_stream.compress(new)
+    simulation = Simulation()
+    try:
+        simulation.wait_ready()
+        uploader.upload(simulation.port, old, 'plain', framing=framing, check=check)
+        # The bootloader is back after the install of A
+        simulation.wait_ready()
+        if simulation.read_pflash(OLD_FIRMWARE_START_ADDRESS, len(old)) != old:
+            raise uploader.UploadError('the old firmware is not installed')
+        uploader.upload(simulation.port, image, mode, framing=framing, check=check)
+        simulation.wait_jump()
+        installed = simulation.read_pflash(OLD_FIRMWARE_START_ADDRESS, len(new))
+    finally:
+        simulation.close()
+    if installed != new:
+        mismatch = next(i for i in range(len(new)) if i >= len(installed) or installed[i] != new[i])
+        raise uploader.UploadError('the installed firmware differs from the new image at offset %d' % mismatch)
+    return len(image)
+
+
+def main(argv):
+    args = argv[1:]
+    options = {'--framing': 'plain', '--check': 'sum'}
+    while args:
+        arg = args.pop(0)
+        if arg in options and args:
+            options[arg] = args.pop(0)
+        else:
+            options = None
+            break
+    if options is None or options['--framing'] not in uploader.FRAMINGS or options['--check'] not in uploader.CHECKS:
+        print('usage: update_test.py [--framing plain|cobs] [--check sum|crc16]')
+        return 1
+    if not os.path.exists(download_benchmark.SIM_PATH):
+        print('%s not found, build it by make -C Host' % download_benchmark.SIM_PATH)
+        return 1
+
+    old, new = make_images(20000)
+    failures = 0
+    for mode in ('delta', 'compressed'):
+        try:
+            image_size = run_case(mode, old, new, options['--framing'], options['--check'])
+        except uploader.UploadError as error:
+            print('%-10s FAILED: %s' % (mode, error))
+            failures += 1
+            continue
+        print('%-10s ok: %d bytes installed from %d bytes sent' % (mode, len(new), image_size))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,325 @@
+#!/usr/bin/env python3
+#
+# uploader.py
+#
+#  Created on: Oct 18, 2026
+#
+# Reference PC uploader for the bootloader (see the data packets in include/pc_communication.h).
+#
+#   uploader.py port image.bin [options]
+#       --mode plain|window|delta|compressed   WriteFlashMemory (stop and wait, default),
+#                                              WriteFlashMemorySequenced, WriteDeltaPatchSequenced
+#                                              or WriteCompressedSequenced (sliding window)
+#       --baud N        switch to N baud (SetBaudRate) after connecting at 115200
+#       --frame N       program data bytes per data packet, a multiple of 8 up to 248 (default 248)
+#       --resume ID     continue the image with the id where it was interrupted (QueryResumePoint)
+#       --no-install    end with ResetNotOK: the image is not installed
+#       --framing plain|cobs    COBS encoded data packets ended by 0x00, for a bootloader built with
+#                               PC2UART_FRAMING_COBS (default plain)
+#       --check sum|crc16       data packets ended by the 8-bit checksum (default) or the CRC-16, for a bootloader
+#                               built with PC2UART_FRAME_CRC16
+#
+# port is a serial port (COM3, /dev/ttyUSB0) or the pty of the host simulation (Host/).
+# The image of the delta and compressed modes is made by delta_patch.py and lz4_stream.py.
+# Requires pyserial.
+
+import binascii
+import struct
+import sys
+import time
+
+import serial
+
+DATA_PACKET_HEADER = 0x55
+DATA_PACKET_TYPE_PUT_DATA = 0x0B
+
+# PC commands
+WRITE_FLASH_MEMORY = 0x01
+RESET_OK = 0x02
+RESET_NOT_OK = 0x03
+WRITE_FLASH_MEMORY_SEQUENCED = 0x04
+SET_BAUD_RATE = 0x05
+WRITE_DELTA_PATCH_SEQUENCED = 0x06
+WRITE_COMPRESSED_SEQUENCED = 0x07
+QUERY_RESUME_POINT = 0x08
+
+# MCU answers: type and total size
+ACK_CODE = 0x10
+ERR_CODE = 0x11
+ACK_SEQ_CODE = 0x12
+ERR_SEQ_CODE = 0x13
+RESUME_CODE = 0x14
+ANSWER_SIZES = {ACK_CODE: 4, ERR_CODE: 5, ACK_SEQ_CODE: 5, ERR_SEQ_CODE: 6, RESUME_CODE: 8}
+
+ERRORS = {120: 'write flash memory error', 121: 'checksum error', 122: 'timeout error',
+          123: 'sequence error', 124: 'baud rate error'}
+
+MODES = {
+    'plain': WRITE_FLASH_MEMORY,
+    'window': WRITE_FLASH_MEMORY_SEQUENCED,
+    'delta': WRITE_DELTA_PATCH_SEQUENCED,
+    'compressed': WRITE_COMPRESSED_SEQUENCED,
+}
+
+FRAMINGS = ('plain', 'cobs')
+COBS_FRAME_DELIMITER = 0x00
+CHECKS = ('sum', 'crc16')
+CRC16_SEED = 0xFFFF              # CRC-16/CCITT-FALSE, see include/crc16.h
+
+DEFAULT_BAUD_RATE = 115200
+PROGRAM_DATA_UNIT_SIZE = 8
+PROGRAM_DATA_MAX_SIZE = 248
+WINDOW_SIZE = 8
+ANSWER_TIMEOUT = 2.0
+# The bootloader switches the baud rate and discards the received bytes after its acknowledge has been sent
+BAUD_RATE_SWITCH_DELAY = 0.01
+MAX_RETRIES = 10
+
+
+class UploadError(Exception):
+    pass
+
+
+class UploadStatistics(object):
+    # Host side figures of a download, see download_benchmark.py
+
+    def __init__(self):
+        self.image_bytes = 0
+        self.frames = 0
+        self.frame_bytes = 0            # All bytes sent, with the packet overhead and the retransmissions
+        self.retransmissions = 0
+        self.ack_wait = 0.0             # Time waiting for answers, after the last byte of the frame is sent
+        self.start = time.time()
+        self.end = None
+
+    def elapsed(self):
+        return (self.end or time.time()) - self.start
+
+    def bytes_per_second(self):
+        return self.image_bytes / self.elapsed() if self.elapsed() > 0 else 0.0
+
+
+def data_packet(command, payload, check='sum'):
+    if check == 'crc16':
+        packet = bytearray([DATA_PACKET_HEADER, DATA_PACKET_TYPE_PUT_DATA, len(payload) + 6, command]) + payload
+        packet += struct.pack('<H', binascii.crc_hqx(bytes(packet), CRC16_SEED))
+        return bytes(packet)
+    packet = bytearray([DATA_PACKET_HEADER, DATA_PACKET_TYPE_PUT_DATA, len(payload) + 5, command]) + payload
+    packet.append((-sum(packet)) & 0xFF)
+    return bytes(packet)
+
+
+def cobs_encode(packet):
+    # Every block starts with a code byte: the distance to the next zero, 0xFF for 254 data bytes without zero.
+    encoded = bytearray()
+    block = bytearray()
+    for byte in packet:
+        if byte == 0:
+            encoded += bytes([len(block) + 1]) + block
+            block = bytearray()
+            continue
+        block.append(byte)
+        if len(block) == 254:
+            encoded += b'\xff' + block
+            block = bytearray()
+    encoded += bytes([len(block) + 1]) + block
+    return bytes(encoded) + bytes([COBS_FRAME_DELIMITER])
+
+
+def pad_frame(data):
+    # The program data of a plain image is written in whole flash phrases
+    return data + b'\xff' * ((-len(data)) % PROGRAM_DATA_UNIT_SIZE)
+
+
+class Bootloader(object):
+
+    def __init__(self, port, statistics=None, framing='plain', check='sum'):
+        self.port = port
+        self.statistics = statistics or UploadStatistics()
+        self.framing = framing
+        self.check = check
+
+    def send(self, command, payload=b''):
+        packet = data_packet(command, payload, self.check)
+        if self.framing == 'cobs':
+            packet = cobs_encode(packet)
+        self.port.write(packet)
+        self.port.flush()
+        self.statistics.frame_bytes += len(packet)
+
+    def read_answer(self, timeout=ANSWER_TIMEOUT):
+        # Skip anything else (e.g. the idle message) up to the header of an answer
+        start = time.time()
+        end = start + timeout
+        try:
+            while True:
+                self.port.timeout = max(end - time.time(), 0.0)
+                header = self.port.read(1)
+                if not header:
+                    return None
+                if header[0] != DATA_PACKET_HEADER:
+                    continue
+                answer_type = self.port.read(1)
+                if not answer_type or answer_type[0] not in ANSWER_SIZES:
+                    continue
+                size = ANSWER_SIZES[answer_type[0]]
+                rest = self.port.read(size - 2)
+                if len(rest) != size - 2 or rest[0] != size:
+                    continue
+                if (DATA_PACKET_HEADER + answer_type[0] + sum(rest)) & 0xFF != 0:
+                    continue
+                return answer_type[0], bytes(rest[1:-1])
+        finally:
+            self.statistics.ack_wait += time.time() - start
+
+    def wait_ready(self, timeout=10.0):
+        # The bootloader waiting for a download sends the idle message every second
+        end = time.time() + timeout
+        self.port.timeout = 0.1
+        received = b''
+        while time.time() < end:
+            received = (received + self.port.read(64))[-64:]
+            if b'Please download' in received:
+                self.port.reset_input_buffer()
+                return
+        raise UploadError('the bootloader is not waiting for a download')
+
+    def set_baud_rate(self, baud_rate):
+        self.send(SET_BAUD_RATE, struct.pack('<I', baud_rate))
+        answer = self.read_answer()
+        if answer is None or answer[0] != ACK_CODE:
+            raise UploadError('baud rate %d rejected' % baud_rate)
+        # The answer has been sent at the old baud rate, the first data packet confirms the new one.
+        self.port.baudrate = baud_rate
+        time.sleep(BAUD_RATE_SWITCH_DELAY)
+
+    def query_resume_point(self, image_id):
+        self.send(QUERY_RESUME_POINT, struct.pack('<I', image_id))
+        answer = self.read_answer()
+        if answer is None or answer[0] != RESUME_CODE:
+            raise UploadError('no resume point')
+        return struct.unpack('<I', answer[1])[0]
+
+    def write_stop_and_wait(self, image, frame_size):
+        # WriteFlashMemory does not write a data packet with a checksum error, the frame is sent again.
+        # Without an answer it is not known if the frame has been written, so it cannot be sent again.
+        for offset in range(0, len(image), frame_size):
+            for retry in range(MAX_RETRIES + 1):
+                if retry > 0:
+                    self.statistics.retransmissions += 1
+                self.send(WRITE_FLASH_MEMORY, pad_frame(image[offset:offset + frame_size]))
+                answer = self.read_answer()
+                if answer is None:
+                    raise UploadError('frame at %d not acknowledged' % offset)
+                if answer[0] == ACK_CODE or answer[1][0] != 121:
+                    break
+            if answer[0] != ACK_CODE:
+                raise UploadError('frame at %d: %s' % (offset, ERRORS.get(answer[1][0], 'error %d' % answer[1][0])))
+            self.statistics.frames += 1
+
+    def write_sequenced(self, command, image, frame_size):
+        # Go-Back-N: up to WINDOW_SIZE unacknowledged frames, resend from the sequence number of a no acknowledge
+        frames = [image[offset:offset + frame_size] for offset in range(0, len(image), frame_size)]
+        if command == WRITE_FLASH_MEMORY_SEQUENCED:
+            frames = [pad_frame(frame) for frame in frames]
+        base = 0                # The first frame not acknowledged
+        next_frame = 0          # The next frame to send
+        retries = 0
+        while base < len(frames):
+            while next_frame < len(frames) and next_frame < base + WINDOW_SIZE:
+                self.send(command, bytes([next_frame & 0xFF]) + frames[next_frame])
+                next_frame += 1
+            answer = self.read_answer()
+            if answer is None:
+                # Nothing acknowledged in time: send the window again
+                retries += 1
+                self.statistics.retransmissions += next_frame - base
+                next_frame = base
+            elif answer[0] == ACK_SEQ_CODE:
+                acknowledged = base + ((answer[1][0] - base) & 0xFF) + 1
+                if acknowledged <= next_frame:
+                    base = acknowledged
+                    retries = 0
+            elif answer[0] == ERR_SEQ_CODE:
+                error, sequence = answer[1][0], answer[1][1]
+                if error == 120:
+                    raise UploadError('frame %d: %s' % (base, ERRORS[120]))
+                resend = base + ((sequence - base) & 0xFF)
+                if resend <= next_frame:
+                    base = resend
+                    retries += 1
+                    self.statistics.retransmissions += next_frame - base
+                    next_frame = base
+            if retries > MAX_RETRIES:
+                raise UploadError('frame %d not acknowledged' % base)
+        self.statistics.frames += len(frames)
+
+    def finish(self, install=True):
+        # No answer: the bootloader resets
+        self.send(RESET_OK if install else RESET_NOT_OK)
+        self.port.flush()
+
+
+def upload(port, image, mode='plain', baud_rate=None, frame_size=PROGRAM_DATA_MAX_SIZE, resume_id=None, install=True,
+           framing='plain', check='sum'):
+    '''
+    Download an image to the bootloader waiting for a download on the open port.
+    @return: the UploadStatistics of the download
+    '''
+    if frame_size % PROGRAM_DATA_UNIT_SIZE != 0 or not 0 < frame_size <= PROGRAM_DATA_MAX_SIZE:
+        raise UploadError('the frame size must be a multiple of 8 up to 248')
+    bootloader = Bootloader(port, framing=framing, check=check)
+    statistics = bootloader.statistics
+    if baud_rate and baud_rate != port.baudrate:
+        bootloader.set_baud_rate(baud_rate)
+    if resume_id is not None:
+        offset = bootloader.query_resume_point(resume_id)
+        print('resume at %d' % offset)
+        image = image[offset:]
+    statistics.image_bytes = len(image)
+    command = MODES[mode]
+    if command == WRITE_FLASH_MEMORY:
+        bootloader.write_stop_and_wait(image, frame_size)
+    else:
+        bootloader.write_sequenced(command, image, frame_size)
+    statistics.end = time.time()
+    bootloader.finish(install)
+    return statistics
+
+
+def main(argv):
+    args = argv[1:]
+    options = {'--mode': 'plain', '--baud': None, '--frame': str(PROGRAM_DATA_MAX_SIZE), '--resume': None,
+               '--framing': 'plain', '--check': 'sum'}
+    install = True
+    positional = []
+    while args:
+        arg = args.pop(0)
+        if arg == '--no-install':
+            install = False
+        elif arg in options and args:
+            options[arg] = args.pop(0)
+        else:
+            positional.append(arg)
+    if (len(positional) != 2 or options['--mode'] not in MODES or options['--framing'] not in FRAMINGS or
+            options['--check'] not in CHECKS):
+        print('usage: uploader.py port image.bin [--mode plain|window|delta|compressed] [--baud N] [--frame N]')
+        print('                   [--resume ID] [--no-install] [--framing plain|cobs] [--check sum|crc16]')
+        return 1
+    with open(positional[1], 'rb') as f:
+        image = f.read()
+    with serial.Serial(positional[0], DEFAULT_BAUD_RATE, timeout=1.0) as port:
+        Bootloader(port).wait_ready()
+        statistics = upload(port, image, options['--mode'],
+                            int(options['--baud']) if options['--baud'] else None,
+                            int(options['--frame']),
+                            int(options['--resume'], 0) if options['--resume'] else None,
+                            install, options['--framing'], options['--check'])
+    print('%d bytes in %.2f s: %.0f bytes/s, %d frames, %d retransmissions, %.2f s waiting for answers'
+          % (statistics.image_bytes, statistics.elapsed(), statistics.bytes_per_second(),
+             statistics.frames, statistics.retransmissions, statistics.ack_wait))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
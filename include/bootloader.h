@@ -12,11 +12,66 @@
 #include "stdbool.h"
 #include "stdint.h"
 
+/*
+ * The address the code reads and writes an MCU memory address (program flash, FlexRAM, SRAM) at.
+ * On the MCU it is the address itself. The host simulation (Host/) keeps the simulated memories
+ * in host memory and maps the MCU address there.
+ */
+#ifdef HOST_SIMULATION
+#define MEMORY_ADDRESS(address)						(sim_memory_address((uint32_t)(address)))
+#else
+#define MEMORY_ADDRESS(address)						(address)
+#endif
+
+/*
+ * A/B slot boot.
+ * The old firmware area (slot A) and the new firmware area (slot B) are both bootable in place.
+ * A download always goes into the inactive slot, which becomes the active slot on the next reset
+ * after its CRC-32 and entry vector are verified, so no copy is needed.
+ * The application must be linked for the slot it is downloaded into (see FIRMWARE_SLOT_x_START_ADDRESS).
+ * Without this option the new firmware is copied to the old firmware area on the next reset.
+ */
+//#define FIRMWARE_AB_SLOTS							1u
+
+/*
+ * Fast boot.
+ * The size and CRC-32 of the active firmware are recorded in EEPROM once it is verified (after an install
+ * or activation, or by a full verification). The following resets jump to it by firmware_fast_boot() without
+ * the flash initialization and without scanning the image, FIRMWARE_FULL_VERIFY_INTERVAL times, then the
+ * next boot verifies the CRC-32 of the whole image again. A corrupted firmware is not started.
+ * The boots are counted in RAM kept over the warm resets, so the fast path writes no EEPROM.
+ * After a power loss, or if the application has overwritten the count, the next boot verifies fully.
+ */
+//#define FIRMWARE_FAST_BOOT							1u
+#define FIRMWARE_FULL_VERIFY_INTERVAL				(32u)
+
+#define FIRMWARE_SLOT_A								(0u)
+#define FIRMWARE_SLOT_B								(1u)
+
+/*
+ * Resumable download.
+ * The PC command QueryResumePoint passes an image id (the CRC-32 of the image); the download of the
+ * same image continues from the last completed sector, which is kept in EEPROM next to the new firmware status.
+ * Only the plain image commands (WriteFlashMemory / WriteFlashMemorySequenced) can be resumed.
+ */
+#define FLASH_RESUME_IMAGE_ID_NONE					(0xFFFFFFFFu)
+
+/*
+ * Verification by the flash controller.
+ * Every erased sector is blank checked by the Read 1s Section command, and every data block of the download
+ * is checked by one Program Check command sequence over the whole block instead of the read-back by the CPU.
+ * Both read at the user margin level, so marginally erased or programmed cells are caught too.
+ */
+//#define FLASH_VERIFY_BY_COMMAND						1u
+#define FLASH_VERIFY_MARGIN_LEVEL					(0x01u)		// User margin
+
 typedef struct
 {
 	uint8_t 	isNewFirmwareUpdated;
 	uint32_t 	newFirmwareSize;
-	uint32_t 	newFirmwareChecksum;
+	uint32_t 	newFirmwareChecksum;		// CRC-32 of the new firmware (see crc32.h)
+	uint8_t		activeFirmwareSlot;			// FIRMWARE_AB_SLOTS: the slot to boot, FIRMWARE_SLOT_A or FIRMWARE_SLOT_B
+	uint32_t	installedSectorNum;			// Install journal: the number of old firmware sectors already overwritten
 } NEW_FIRMWARE_STATUS_t;
 
 // Public global variables
@@ -27,10 +82,16 @@ extern flash_ssd_config_t flashSSDConfig;
 // Public function prototypes
 bool flash_init(void);
 
-void flash_auto_write_64bytes_reset(void);
-bool flash_auto_write_64bytes(void);
+void flash_auto_write_reset(void);
+bool flash_auto_write_bytes(const uint8_t * pData, uint32_t byteNum);
+uint32_t flash_auto_write_resume(uint32_t imageId);
+bool flash_auto_write_resume_clear(void);
 
 void JumpToOldFirmware(void);
+#ifdef FIRMWARE_FAST_BOOT
+void firmware_fast_boot(bool isPowerLost);
+#endif
+void JumpToFirmware(uint32_t firmwareStartAddress);
 void auto_ram_reset(void);
 void auto_flash_reset(void);
 
@@ -0,0 +1,23 @@
+/*
+ * crc16.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include "stdint.h"
+
+/*
+ * CRC-16/CCITT-FALSE over the PC data packets (PC2UART_FRAME_CRC16).
+ * 		polynomial 0x1021, no reflection, seed 0xFFFF, no final XOR
+ * The same CRC as binascii.crc_hqx(data, 0xFFFF) of Python. Check value: "123456789" -> 0x29B1.
+ */
+#define CRC16_POLYNOMIAL				(0x1021u)
+#define CRC16_SEED						(0xFFFFu)
+
+// Public function prototypes
+uint16_t crc16_update(uint16_t crc, const uint8_t * pData, uint32_t byteNum);
+
+#endif /* CRC16_H_ */
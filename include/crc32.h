@@ -0,0 +1,38 @@
+/*
+ * crc32.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * CRC-32 (IEEE 802.3, as zlib / Ethernet) over the firmware images.
+ * 		polynomial 0x04C11DB7, reflected input and output, seed 0xFFFFFFFF, final XOR 0xFFFFFFFF
+ *
+ * The S32K144 CRC module is used by default.
+ * Define CRC32_USE_SOFTWARE to use the table-driven (slice-by-4) software CRC instead,
+ * e.g. when the code is built on a PC.
+ */
+//#define CRC32_USE_SOFTWARE				1u
+
+#define CRC32_POLYNOMIAL				(0x04C11DB7u)
+#define CRC32_POLYNOMIAL_REFLECTED		(0xEDB88320u)
+#define CRC32_SEED						(0xFFFFFFFFu)
+
+// Public function prototypes
+void crc32_init(void);
+
+// Streaming calculation, one at a time
+void crc32_start(void);
+void crc32_update(const uint8_t * pData, uint32_t byteNum);
+uint32_t crc32_result(void);
+
+// One-shot calculation
+uint32_t crc32_calculate(const uint8_t * pData, uint32_t byteNum);
+
+#endif /* CRC32_H_ */
@@ -0,0 +1,53 @@
+/*
+ * delta_patch.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef DELTA_PATCH_H_
+#define DELTA_PATCH_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * Delta patch format (all multi-byte fields are little-endian)
+ *
+ * Header (20 bytes):
+ * 		'D', 'P', version (0x02), reserved (0x00)
+ * 		u32 old image size		The number of bytes of the installed firmware the patch is made against
+ * 		u32 old image checksum	The CRC-32 (crc32.h) of the old image
+ * 		u32 new image size
+ * 		u32 new image checksum	The CRC-32 of the new image
+ *
+ * Followed by opcodes until the end opcode:
+ * 		0x00								END
+ * 		0x01, u32 offset, u32 length		COPY length bytes from the old image at offset
+ * 		0x02, u16 length, length bytes		INSERT the literal bytes
+ *
+ * The new image is rebuilt in the new firmware area, the old image is read from the old firmware area.
+ * The decoder streams the new image through the CRC calculation (crc32_start()/crc32_update()) from the header
+ * to delta_patch_finish(), no other CRC calculation may run meanwhile.
+ * Tools/delta_patch.py generates and applies patches on the PC.
+ */
+#define DELTA_PATCH_MAGIC_0				('D')
+#define DELTA_PATCH_MAGIC_1				('P')
+#define DELTA_PATCH_VERSION				(0x02u)
+#define DELTA_PATCH_HEADER_SIZE			(20u)
+
+#define DELTA_PATCH_OP_END				(0x00u)
+#define DELTA_PATCH_OP_COPY				(0x01u)
+#define DELTA_PATCH_OP_INSERT			(0x02u)
+
+// The output block size handed to the write function, multiple of 8
+#define DELTA_PATCH_OUTPUT_BLOCK_SIZE	(248u)
+
+// Write the next output block of the new image (e.g. flash_auto_write_bytes())
+typedef bool (*DELTA_PATCH_WRITE_t)(const uint8_t * pData, uint32_t byteNum);
+
+// Public function prototypes
+void delta_patch_reset(const uint8_t * pOldImage, uint32_t oldImageMaxSize, DELTA_PATCH_WRITE_t pWrite);
+bool delta_patch_input(const uint8_t * pData, uint32_t byteNum);
+bool delta_patch_finish(void);
+
+#endif /* DELTA_PATCH_H_ */
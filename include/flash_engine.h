@@ -0,0 +1,59 @@
+/*
+ * flash_engine.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FLASH_ENGINE_H_
+#define FLASH_ENGINE_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * Program the 16-bytes aligned part of each data block with one FTFC Program Section command,
+ * using FlexRAM as the section program buffer.
+ * FlexRAM is switched from Emulated EEPROM to RAM during the download and back before the EEPROM is accessed.
+ */
+//#define FLASH_USE_PROGRAM_SECTION		1u
+
+// The number of flash jobs that can be queued
+#define FLASH_ENGINE_QUEUE_SIZE			(8u)		// Power of 2
+
+// Flash job types
+typedef enum
+{
+	FLASH_ENGINE_JOB_ERASE_SECTOR = 0u,		// Erase the sector at the address (Erase Flash Sector)
+	FLASH_ENGINE_JOB_PROGRAM,				// Program the data (Program Phrase, or Program Section)
+	FLASH_ENGINE_JOB_VERIFY_BLANK,			// Blank check of the 16-bytes units at the address (Read 1s Section)
+} FLASH_ENGINE_JOB_TYPE_t;
+
+/*
+ * Called from the FTFC interrupt when a job has finished, between two flash commands (the flash is idle).
+ * The callback must not submit flash jobs.
+ */
+typedef void (*FLASH_ENGINE_CALLBACK_t)(bool isSuccessful, uint32_t param);
+
+typedef struct
+{
+	FLASH_ENGINE_JOB_TYPE_t type;
+	uint32_t address;					// Program flash address
+	uint32_t byteNum;					// FLASH_SECTOR_SIZE, multiple of 8 (program) or multiple of 16 (blank check)
+	const uint8_t * pData;				// The data to program (any alignment), valid until the job has finished
+	FLASH_ENGINE_CALLBACK_t callback;	// Optional
+	uint32_t param;						// Passed to the callback
+} FLASH_ENGINE_JOB_t;
+
+// Public function prototypes
+void flash_engine_init(void);
+bool flash_engine_submit(const FLASH_ENGINE_JOB_t * pJob);
+bool flash_engine_wait(void);
+bool flash_engine_is_busy(void);
+#ifdef FLASH_USE_PROGRAM_SECTION
+bool flash_engine_set_section_buffer(bool enable);
+#endif
+
+void flash_engine_mask_irq(void);
+void flash_engine_unmask_irq(void);
+
+#endif /* FLASH_ENGINE_H_ */
@@ -0,0 +1,51 @@
+/*
+ * lz4_stream.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef LZ4_STREAM_H_
+#define LZ4_STREAM_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * Compressed image format (all multi-byte fields are little-endian)
+ *
+ * Header (12 bytes):
+ * 		'L', 'Z', version (0x02), reserved (0x00)
+ * 		u32 image size			The number of bytes of the decompressed image
+ * 		u32 image checksum		The CRC-32 (crc32.h) of the decompressed image
+ *
+ * Followed by LZ4 block sequences until the image size is reached:
+ * 		token					high nibble: literal length, low nibble: match length - 4
+ * 		[literal length bytes]	255 continues, if the high nibble is 15
+ * 		literals
+ * 		u16 offset				The distance back from the current output position (omitted by the last sequence)
+ * 		[match length bytes]	255 continues, if the low nibble is 15
+ *
+ * The back references are read from the already decompressed image, which is in the new firmware area
+ * except for the last output block, so no history window is kept in RAM.
+ * The decoder streams the image through the CRC calculation (crc32_start()/crc32_update()) from the header
+ * to lz4_stream_finish(), no other CRC calculation may run meanwhile.
+ * Tools/lz4_stream.py compresses and decompresses images on the PC.
+ */
+#define LZ4_STREAM_MAGIC_0				('L')
+#define LZ4_STREAM_MAGIC_1				('Z')
+#define LZ4_STREAM_VERSION				(0x02u)
+#define LZ4_STREAM_HEADER_SIZE			(12u)
+#define LZ4_STREAM_MIN_MATCH			(4u)
+
+// The output block size handed to the write function, multiple of 8
+#define LZ4_STREAM_OUTPUT_BLOCK_SIZE	(248u)
+
+// Write the next output block of the image (e.g. flash_auto_write_bytes())
+typedef bool (*LZ4_STREAM_WRITE_t)(const uint8_t * pData, uint32_t byteNum);
+
+// Public function prototypes
+void lz4_stream_reset(const uint8_t * pOutputImage, uint32_t outputImageMaxSize, LZ4_STREAM_WRITE_t pWrite);
+bool lz4_stream_input(const uint8_t * pData, uint32_t byteNum);
+bool lz4_stream_finish(void);
+
+#endif /* LZ4_STREAM_H_ */
@@ -16,10 +16,86 @@
 //#define DEBUG_FROM_RAM							1u
 #define RUN_FROM_FLASH								1u
 //#define TEST_FIRMWARE_UPDATE_NO_FLASH_WRITE			1u
+/*
+ * UART RX by eDMA: the eDMA channel continuously fills the RX ring buffer from LPUART0 in a loop
+ * and the receiver reads the eDMA destination position, instead of one RX interrupt per byte.
+ */
+//#define UART_RX_USE_DMA								1u
+/*
+ * COBS framing: the PC sends every data packet COBS encoded (Consistent Overhead Byte Stuffing) and ended by
+ * the frame delimiter 0x00, which never occurs inside a frame. After a corrupted byte the receiver restarts at the
+ * next delimiter, instead of searching a 0x55 header that may be a data payload byte.
+ * With the RX interrupt, an idle line of 2^PC2UART_IDLE_LINE_CONFIG characters also ends the frame (the delimiter is lost).
+ * The MCU answers are not encoded.
+ */
+//#define PC2UART_FRAMING_COBS						1u
+#define COBS_FRAME_DELIMITER						0x00u
+#define PC2UART_IDLE_LINE_CONFIG					7u		// LPUART CTRL[IDLECFG]: 128 idle characters
+/*
+ * CRC-16 data packets: the PC ends every data packet by the CRC-16 (crc16.h, little-endian) of all its bytes
+ * instead of the 8-bit checksum, so the data packet size includes 2 check bytes. The 8-bit sum misses transposed
+ * bytes and many burst errors, which become likely at high baud rates. The MCU answers keep the checksum.
+ */
+//#define PC2UART_FRAME_CRC16							1u
+#ifdef PC2UART_FRAME_CRC16
+#define DATA_PACKET_CHECK_LENGTH					2u
+#else
+#define DATA_PACKET_CHECK_LENGTH					1u
+#endif
 
 #define DATA_PACKET_LENGTH							255u
 #define NACK_DATA_PACKET_LENGTH						5u
 #define  ACK_DATA_PACKET_LENGTH						4u
+#define WINDOW_NACK_DATA_PACKET_LENGTH				6u
+#define  WINDOW_ACK_DATA_PACKET_LENGTH				5u
+#define RESUME_POINT_DATA_PACKET_LENGTH				8u
+
+/*
+ * MCU-to-PC Trace Data Packet, the answer to the PC command DumpTrace (u16 first entry index).
+ * 		header, type, size
+ * 		u16 entry number			The number of entries in the trace ring
+ * 		u16 first index				The index of the first entry in this packet (0 is the oldest entry)
+ * 		u32 core clock				The DWT cycle counter frequency in Hz
+ * 		u8 count					The number of entries in this packet
+ * 		count x 8 bytes				u32 cycles, u8 event, u8 phase, u16 arg (see trace.h)
+ * 		checksum
+ * All multi-byte fields are little-endian. The PC asks again from the next index until all entries are read.
+ */
+#define TRACE_DATA_PACKET_HEADER_LENGTH				12u
+#define TRACE_DATA_PACKET_ENTRY_LENGTH				8u
+#define TRACE_DATA_PACKET_MAX_ENTRIES				30u
+
+/*
+ * Sliding window download (PC command WriteFlashMemorySequenced).
+ *
+ * The PC may send up to PC2UART_WINDOW_SIZE sequenced data packets without waiting for an acknowledge.
+ * The MCU programs the packets strictly in sequence order and answers with a cumulative acknowledge
+ * carrying the last sequence number written to flash, at least every PC2UART_ACK_INTERVAL packets.
+ * A lost or corrupted packet is answered once with a no acknowledge carrying the expected sequence number,
+ * then the PC goes back and resends from that sequence number (Go-Back-N).
+ */
+#define PC2UART_WINDOW_SIZE							8u
+#define PC2UART_ACK_INTERVAL						(PC2UART_WINDOW_SIZE / 2u)
+
+/*
+ * Program data size carried by a WriteFlashMemory or WriteFlashMemorySequenced data packet.
+ * Any multiple of 8 bytes (one flash phrase) up to 248 bytes is accepted, so the PC can send
+ * large frames using almost the full 250 bytes payload instead of 64 bytes.
+ */
+#define PROGRAM_DATA_UNIT_SIZE						8u
+#define PROGRAM_DATA_MAX_SIZE						248u
+
+/*
+ * Baud rate negotiation (PC command SetBaudRate).
+ *
+ * The PC proposes a baud rate in raw_data[0..3] (little-endian). If the LPUART clock can generate it
+ * within PC2UART_BAUD_RATE_MAX_ERROR (per mille), the MCU acknowledges at the old baud rate and switches.
+ * The first data packet at the new baud rate confirms the switch. If it is corrupted, or none arrives within
+ * PC2UART_BAUD_RATE_CONFIRM_TIME, the MCU falls back to the old baud rate.
+ */
+#define PC2UART_MAX_BAUD_RATE						2000000u
+#define PC2UART_BAUD_RATE_MAX_ERROR					20u		// 20 per mille = 2%
+#define PC2UART_BAUD_RATE_CONFIRM_TIME				5u		// 5*200ms = 1s
 
 
 /*
@@ -34,8 +110,9 @@ typedef union
 		uint8_t type;			// packet type / packet identifier = 0..255
 		uint8_t size;			// packet size = total amount of bytes in a received data packet
 		uint8_t command;		// PC command field
-		uint8_t raw_data[250];	// raw data payload
+		uint8_t raw_data[250];	// raw data payload (WriteFlashMemorySequenced: raw_data[0] = sequence number, raw_data[1..] = program data)
 		uint8_t checksum; 		// (header + type + size + raw_data[0...] + checksum) % 256 == 0
+								// The checksum (or CRC-16) directly follows the data payload, this is its place in a full size data packet only.
 	} item;
 } DATA_PACKET_t;
 
@@ -72,6 +149,57 @@ typedef union
 	} item;
 } ACK_DATA_PACKET_t;
 
+/*
+ * MCU-to-PC Sliding Window No Acknowledge Data Packet
+ */
+typedef union
+{
+	uint8_t buffer[WINDOW_NACK_DATA_PACKET_LENGTH];
+	struct
+	{
+		uint8_t header;
+		uint8_t type;
+		uint8_t size;
+		uint8_t error_info;
+		uint8_t sequence;		// The sequence number the MCU expects next
+		uint8_t checksum;
+	} item;
+} WINDOW_NACK_DATA_PACKET_t;
+
+
+/*
+ * MCU-to-PC Sliding Window Acknowledge Data Packet
+ */
+typedef union
+{
+	uint8_t buffer[WINDOW_ACK_DATA_PACKET_LENGTH];
+	struct
+	{
+		uint8_t header;
+		uint8_t type;
+		uint8_t size;
+		uint8_t sequence;		// The last sequence number written to flash (cumulative acknowledge)
+		uint8_t checksum;
+	} item;
+} WINDOW_ACK_DATA_PACKET_t;
+
+/*
+ * MCU-to-PC Resume Point Data Packet, the answer to the PC command QueryResumePoint.
+ * The PC continues the plain image from the resume offset, with the sequence number 0.
+ */
+typedef union
+{
+	uint8_t buffer[RESUME_POINT_DATA_PACKET_LENGTH];
+	struct
+	{
+		uint8_t header;
+		uint8_t type;
+		uint8_t size;
+		uint8_t offset[4];		// The resume offset in the image, little-endian
+		uint8_t checksum;
+	} item;
+} RESUME_POINT_DATA_PACKET_t;
+
 /*
  * The finite state set for PC-to-UART Receiver State Machine
  */
@@ -87,19 +215,26 @@ typedef enum
 	CHECK_RX_DATA_PACKET,					// Check if the extracted data packet is correct and execute the PC command.
 	WRITE_RPOGRAM_TO_FLASH,					// Execute PC command to write flash.
 	SEND_ACKNOWLEDGE_MSG,					// Send the acknowledge message to PC after writing a data packet to flash.
+	CHECK_RX_DATA_PACKET_SEQUENCE,			// Check the sequence number of a sliding window data packet.
+	WRITE_SEQUENCED_PROGRAM_TO_FLASH,		// Write a sliding window data packet to flash and acknowledge cumulatively.
 	UPDATE_FIRMWARE_STATUS,					// End the data packet download and flash write, update the firmware status.
 	RESET_MCU,								// Execute PC command to reset MCU.
 } UART_RECEIVER_STATE_t;
 
 /*
  * UART Receive FIFO Ring Buffer Structure
+ *
+ * Single producer (the RX interrupt, or the eDMA position) and single consumer (the receiver state machine):
+ * the producer writes putByteIndex only, the consumer writes getByteIndex only, so no critical section is needed.
+ * Both indexes run freely, the number of used bytes is their difference and the buffer position is
+ * the index masked by the power-of-2 ring buffer size.
  */
 typedef struct
 {
-	uint16_t putByteIndex;
-	uint16_t getByteIndex;
-	uint16_t usedBytesCount;		// Count the number of bytes that are already in the ring buffer.
-	uint16_t size;
+	volatile uint32_t putByteIndex;
+	volatile uint32_t getByteIndex;
+	volatile uint32_t overrunCount;		// Count the received bytes lost, because the ring buffer was full or by LPUART receiver overrun.
+	volatile uint32_t highWaterMark;	// The largest number of bytes that have been in the ring buffer.
 	uint8_t * pRingBuffer;
 } FIFO_RING_BUFFER_t;
 
@@ -0,0 +1,68 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "stdbool.h"
+#include "stdint.h"
+
+/*
+ * Phase latency tracing.
+ * Every traced phase (sector erase, frame program, verify, EEPROM write, jump...) records a begin and an end
+ * entry time-stamped by the Cortex-M4 DWT cycle counter (core clock cycles) into a RAM ring.
+ * The ring survives the warm resets (e.g. the reset after a download), so the boot after an update can be
+ * dumped too; it is cleared after a power loss. The PC command DumpTrace reads the ring over UART.
+ *
+ * Define TRACE_ENABLE to record the trace. Without it the TRACE_BEGIN/TRACE_END/TRACE_EVENT macros are empty
+ * and the dump returns no entries.
+ */
+//#define TRACE_ENABLE								1u
+
+// The number of entries kept in the ring, the oldest entries are overwritten
+#define TRACE_RING_SIZE								(128u)
+
+// Traced phases
+#define TRACE_EVENT_RESET							(1u)		// arg: reset source (RCM SRS, low 16 bits)
+#define TRACE_EVENT_FIRMWARE_UPDATE					(2u)		// The boot decision in firmware_update()
+#define TRACE_EVENT_ERASE_SECTOR					(3u)		// arg: sector index
+#define TRACE_EVENT_PROGRAM							(4u)		// arg: the number of bytes of the frame
+#define TRACE_EVENT_VERIFY							(5u)		// arg: the number of bytes read back
+#define TRACE_EVENT_VERIFY_IMAGE					(6u)		// CRC-32 of a firmware image, arg: size in kB
+#define TRACE_EVENT_EEPROM_WRITE					(7u)
+#define TRACE_EVENT_INSTALL_SECTOR					(8u)		// Copy of one sector to the old firmware area, arg: sector index
+#define TRACE_EVENT_JUMP							(9u)		// The jump to the firmware
+#define TRACE_EVENT_FAST_BOOT						(10u)		// The fast boot decision, end arg: 1 if the fast path is taken
+
+#define TRACE_PHASE_BEGIN							(0u)
+#define TRACE_PHASE_END								(1u)
+#define TRACE_PHASE_POINT							(2u)
+
+typedef struct
+{
+	uint32_t	cycles;			// DWT cycle counter
+	uint8_t		event;			// TRACE_EVENT_x
+	uint8_t		phase;			// TRACE_PHASE_x
+	uint16_t	arg;
+} TRACE_ENTRY_t;
+
+#ifdef TRACE_ENABLE
+#define TRACE_BEGIN(event, arg)						trace_record((event), TRACE_PHASE_BEGIN, (uint16_t)(arg))
+#define TRACE_END(event, arg)						trace_record((event), TRACE_PHASE_END, (uint16_t)(arg))
+#define TRACE_EVENT(event, arg)						trace_record((event), TRACE_PHASE_POINT, (uint16_t)(arg))
+#else
+#define TRACE_BEGIN(event, arg)
+#define TRACE_END(event, arg)
+#define TRACE_EVENT(event, arg)
+#endif
+
+// Public function prototypes
+void trace_init(bool isPowerLost);
+void trace_record(uint8_t event, uint8_t phase, uint16_t arg);
+uint32_t trace_get_count(void);
+bool trace_get_entry(uint32_t index, TRACE_ENTRY_t * pEntry);
+
+#endif /* TRACE_H_ */